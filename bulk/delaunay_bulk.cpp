@@ -0,0 +1,59 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "bulkinsertion.hpp"
+#include "common.hpp"
+#include <iostream>
+
+using namespace std;
+
+// The first half of the points is the existing mesh, the rest comes in batches of this size
+const int BATCH_SIZE = 10000;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_bulk.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+
+    vector<int> initialPoints;
+    for (int i = 0; i < N / 2; i++) {
+        initialPoints.push_back(i);
+    }
+    bowyerWatson.AddPointsAndRetriangulate(initialPoints);
+
+    // Insert the remaining points batch by batch into the existing mesh
+    BulkInsertion<> bulkInsertion = BulkInsertion<>(bowyerWatson);
+    for (int begin = N / 2; begin < N; begin += BATCH_SIZE) {
+        vector<int> batch;
+        for (int i = begin; i < min(N, begin + BATCH_SIZE); i++) {
+            batch.push_back(i);
+        }
+        bulkInsertion.AddPoints(batch);
+    }
+
+    bowyerWatson.RemoveSuperTriangle();
+    if (!bowyerWatson.skippedPoints.empty()) {
+        cerr << bowyerWatson.skippedPoints.size() << " points left out" << endl;
+    }
+
+    triangulation.Print();
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "constrained.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <fstream>
+
+using namespace std;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_constrained.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+
+    vector<int> order;
+    for (int i = 0; i < N; i++) {
+        order.push_back(i);
+    }
+    bowyerWatson.AddPointsAndRetriangulate(order);
+    bowyerWatson.RemoveSuperTriangle();
+
+    // The segments are read as pairs of point ids: M, then p1 p2 on every line
+    // Segments that can't be inserted (see ConstraintError) are left out
+    ConstrainedDelaunay<> constrained = ConstrainedDelaunay<>(triangulation);
+    ifstream constraintsFile("data/delaunay_constraints.in");
+    int M = 0;
+    if (!constraintsFile) {
+        cerr << "No data/delaunay_constraints.in, the triangulation has no segments" << endl;
+    } else if (!(constraintsFile >> M) || M < 0) {
+        cerr << "Can't read the number of segments" << endl;
+        return 1;
+    }
+
+    for (int i = 0; i < M; i++) {
+        int p1, p2;
+        if (!(constraintsFile >> p1 >> p2)) {
+            cerr << "Can't read segment " << i + 1 << " of " << M << endl;
+            return 1;
+        }
+
+        if (p1 < 0 || p1 >= N || p2 < 0 || p2 >= N) {
+            cerr << "Segment " << p1 << " " << p2 << " uses a point id out of range" << endl;
+            continue;
+        }
+
+        if (!constrained.InsertConstraint(p1, p2)) {
+            cerr << "Segment " << p1 << " " << p2;
+            if (constrained.error == CONSTRAINT_MISSING_POINT) {
+                cerr << " uses a point left out of the triangulation" << endl;
+            } else if (constrained.error == CONSTRAINT_CROSSES_SEGMENT) {
+                cerr << " crosses another segment" << endl;
+            } else {
+                cerr << " goes out of the triangulation" << endl;
+            }
+        }
+    }
+
+    triangulation.Print();
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include "triangulation.hpp"
+#include "divideandconquer.hpp"
+#include "common.hpp"
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_divideandconquer.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    DivideAndConquer<> divideAndConquer = DivideAndConquer<>(triangulation);
+    divideAndConquer.Triangulate();
+
+    triangulation.Print();
+
+    return 0;
+}
@@ -8,9 +8,9 @@ vector<Vector3> points;
 using namespace std;
 
 // Creates a triangulation using only the points on the convex hull
-void InitConvexHullTriangulation(vector<Vector3>points, Triangulation& triangulation)
+void InitConvexHullTriangulation(const vector<Vector3>& points, Triangulation& triangulation)
 {
-    vector<int> convexPoints = ComputeConvexHull(points);
+    const vector<int>& convexPoints = triangulation.GetConvexHull().points;
 
     for (int i = 1; i < convexPoints.size() - 1; i++) {
         TriangulationNode node;
@@ -26,20 +26,13 @@ void InitConvexHullTriangulation(vector<Vector3>points, Triangulation& triangula
 }
 
 // Look for points that are not on the convex hull and add them to the triangulation
-void InsertNonConvexHullPoints(vector<Vector3> points, Triangulation& triangulation)
+void InsertNonConvexHullPoints(const vector<Vector3>& points, Triangulation& triangulation)
 {
-    vector<int> convexPoints = ComputeConvexHull(points);
+    // The hull was already computed when the triangulation was initialised
+    const ConvexHull& convexHull = triangulation.GetConvexHull();
 
     for (int i = 0; i < points.size(); i++) {
-        bool inConvexHull = false;
-        for (int j = 0; j < convexPoints.size(); j++) {
-            if (convexPoints[j] == i) {
-                inConvexHull = true;
-                break;
-            }
-        }
-
-        if (inConvexHull) {
+        if (convexHull.Contains(i)) {
             continue;
         }
 
@@ -54,7 +47,7 @@ void InsertNonConvexHullPoints(vector<Vector3> points, Triangulation& triangulat
 
 // Look for triangles not respecting the delaunay condition and flip the common edge
 // until the triangulation becomes a delaunay triangulation
-void FlipEdges(vector<Vector3> points, Triangulation& triangulation)
+void FlipEdges(const vector<Vector3>& points, Triangulation& triangulation)
 {
     bool isDelaunay = false;
     while (!isDelaunay)
@@ -68,6 +61,12 @@ void FlipEdges(vector<Vector3> points, Triangulation& triangulation)
                     continue;
                 }
 
+                // Constrained edges are never flipped
+                if (triangulation.IsConstrained(triangulation.nodes[i].points[(j + 1) % 3],
+                                                triangulation.nodes[i].points[(j + 2) % 3])) {
+                    continue;
+                }
+
                 int p1, p2, p3, p4;
                 p1 = triangulation.nodes[t1].points[0];
                 p2 = triangulation.nodes[t1].points[1];
@@ -0,0 +1,554 @@
+#ifndef __BOWYERWATSON__H
+#define __BOWYERWATSON__H
+
+#include <vector>
+#include <algorithm>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include "convexhull.hpp"
+#include "constrained.hpp"
+
+using namespace std;
+
+// Store the info for an edge of the polygon-hole that needs to be retriangulated
+struct PolygonEdge {
+    // the neighbouring triangle for this edge from outside the polygon
+    int nodeId;
+
+    // Edge
+    int p1;
+    int p2;
+};
+
+// Incremental Bowyer-Watson insertion on top of a Triangulation
+// The work vectors are kept between insertions so every insertion only touches its own cavity
+// The cavities are found with the filtered predicates (see FilteredKernel), so they stay star shaped around
+// the new point even for (almost) cocircular points
+template <typename Kernel = DefaultKernel>
+class BowyerWatson {
+public:
+    Triangulation& triangulation;
+    Kernel kernel;
+    FilteredKernel<Kernel> filtered;
+
+    vector<int> queue;
+    vector<int> badTriangles;
+    vector<int> visitedNodes;
+    vector<PolygonEdge> edges;
+    vector<pair<int, int>> pointTriangles;
+
+    // Triangles created by the last insertion
+    vector<int> newTriangles;
+
+    // Ids of the super triangle points
+    int superPoints[3];
+
+    // Points left out by AddPointAndRetriangulate: duplicates of a point already in the triangulation, and
+    // skipped points, outside of it (outside the super triangle, or outside the hull once the super triangle
+    // is gone) or with a cavity that couldn't be used
+    vector<int> duplicatePoints;
+    vector<int> skippedPoints;
+
+    // Triangle used as the starting point of the next JumpAndWalk
+    int lastNode;
+
+    // Node ids FillCavity uses before adding new nodes to the triangulation
+    vector<int> freeNodes;
+
+    // When set, every node has to be claimed before it is read (parallel insertions, see BulkInsertion)
+    // claimFailed tells the last FindCavity ran into a node owned by another worker
+    NodeOwners* owners;
+    int ownerId;
+    bool claimFailed;
+
+    BowyerWatson(Triangulation& _triangulation, Kernel _kernel = Kernel()) :
+        triangulation(_triangulation), kernel(_kernel), filtered(_kernel), lastNode(0), owners(NULL), ownerId(0),
+        claimFailed(false)
+    {
+        superPoints[0] = superPoints[1] = superPoints[2] = -1;
+    };
+
+    // Adds a super triangle around all the points of the triangulation
+    void GenerateSuperTriangle()
+    {
+        vector<Vector3>& points = triangulation.points;
+        Vector3 boxMin = points.empty() ? Vector3() : points[0];
+        Vector3 boxMax = boxMin;
+        for (int i = 0; i < points.size(); i++) {
+            boxMin = Vector3(min(points[i].x, boxMin.x), min(points[i].y, boxMin.y), 0);
+            boxMax = Vector3(max(points[i].x, boxMax.x), max(points[i].y, boxMax.y), 0);
+        }
+
+        GenerateSuperTriangle(boxMin, boxMax);
+    }
+
+    // Adds a super triangle around the box between boxMin and boxMax. Its points are removed with
+    // RemoveSuperTriangle once all the points are inserted
+    void GenerateSuperTriangle(const Vector3& boxMin, const Vector3& boxMax)
+    {
+        // the super triangle will be the points (x, y + l), (x - l, y - l), (x + l, y - l) around the center
+        // of the box, with l 10 times the size of the box (it has to be 3 times bigger to contain it)
+        double x = (boxMin.x + boxMax.x) / 2;
+        double y = (boxMin.y + boxMax.y) / 2;
+        double l = 10 * max(max(boxMax.x - boxMin.x, boxMax.y - boxMin.y), 1.0);
+
+        Vector3 p1 = Vector3(x, y + l, 0);
+        Vector3 p2 = Vector3(x - l, y - l, 0);
+        Vector3 p3 = Vector3(x + l, y - l, 0);
+
+        int p1ID = triangulation.AddPoint(p1);
+        int p2ID = triangulation.AddPoint(p2);
+        int p3ID = triangulation.AddPoint(p3);
+        superPoints[0] = p1ID;
+        superPoints[1] = p2ID;
+        superPoints[2] = p3ID;
+
+        TriangulationNode node = TriangulationNode();
+        int nodeId = triangulation.AddNode(node);
+        triangulation.EditNode(nodeId, p1ID, p2ID, p3ID, -1, -1, -1);
+        lastNode = nodeId;
+    }
+
+    // Removes the 3 super triangle points (and every triangle using them)
+    // Points added after the super triangle move down to fill the gap
+    void RemoveSuperTriangle()
+    {
+        RestoreHull();
+        triangulation.RemovePoint(superPoints[2]);
+        triangulation.RemovePoint(superPoints[1]);
+        triangulation.RemovePoint(superPoints[0]);
+        lastNode = 0;
+    }
+
+    // The super triangle is not infinitely far, so some hull edges of the points might be missing (the triangles
+    // around them use a super triangle point instead), and removing the super triangle would leave a concave
+    // hull. The missing hull edges are forced in the same way as constrained edges, only the triangles outside
+    // the hull use the super triangle points then and the rest stays delaunay
+    void RestoreHull()
+    {
+        vector<int> loop;
+        ComputeHull(loop, triangulation.points.size());
+        if (loop.empty()) {
+            return;
+        }
+
+        ConstrainedDelaunay<FilteredKernel<Kernel>> constrained(triangulation, filtered);
+        constrained.lastNode = lastNode;
+        for (int i = 0; i < loop.size(); i++) {
+            int p1 = loop[i];
+            int p2 = loop[(i + 1) % loop.size()];
+            if (!triangulation.IsConstrained(p1, p2) && constrained.InsertConstraint(p1, p2)) {
+                triangulation.SetConstrained(p1, p2, false);
+            }
+        }
+        lastNode = constrained.lastNode;
+    }
+
+    // Counterclockwise convex hull of the points in the triangulation with an id below pointsCnt, points on its
+    // edges included, checked with the filtered predicates. Empty if the points are collinear
+    void ComputeHull(vector<int>& loop, int pointsCnt)
+    {
+        vector<Vector3>& points = triangulation.points;
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        loop.clear();
+
+        // Only the points in the triangulation count (not the left out duplicates)
+        vector<char> used(points.size(), 0);
+        for (int i = 0; i < nodes.size(); i++) {
+            for (int x = 0; x < 3; x++) {
+                used[nodes[i].points[x]] = 1;
+            }
+        }
+
+        vector<int> ids;
+        vector<Vector3> hullPoints;
+        for (int i = 0; i < pointsCnt; i++) {
+            if (used[i] && !IsSuperPoint(i)) {
+                ids.push_back(i);
+                hullPoints.push_back(points[i]);
+            }
+        }
+
+        ConvexHull hull(true);
+        hull.Compute(hullPoints);
+        if (hull.points.size() < 3) {
+            return;
+        }
+
+        // The hull keeps every point within EPS of its edges, the ones barely inside it are left out again
+        // (the first point is the lowest one, always on the hull)
+        for (int i = 0; i <= hull.points.size(); i++) {
+            int pointId = ids[hull.points[i % hull.points.size()]];
+            while (loop.size() >= 2 &&
+                   filtered.Orient(points[loop[loop.size() - 2]], points[loop.back()], points[pointId]) < 0) {
+                loop.pop_back();
+            }
+            loop.push_back(pointId);
+        }
+        loop.pop_back();
+
+        // The loop keeps the points on the edges, so collinear points give a loop without any turn
+        bool turns = false;
+        for (int i = 0; i < loop.size() && !turns; i++) {
+            turns = filtered.Orient(points[loop[i]], points[loop[(i + 1) % loop.size()]],
+                                    points[loop[(i + 2) % loop.size()]]) != 0;
+        }
+        if (loop.size() < 3 || !turns) {
+            loop.clear();
+        }
+    }
+
+    // Returns true if the point is one of the super triangle points
+    bool IsSuperPoint(int pointId)
+    {
+        return pointId == superPoints[0] || pointId == superPoints[1] || pointId == superPoints[2];
+    }
+
+    // Adds a node to the queue to be checked
+    // Also marks checks if the node is already added to the queue, and if it isn't
+    // it adds it and marks it as visited
+    void AddQueueNode(int nodeId, int p1Id, int p2Id)
+    {
+        if (nodeId != -1 && visitedNodes[nodeId])
+        {
+            return;
+        }
+
+        if (nodeId != -1)
+        {
+            visitedNodes[nodeId] = 1;
+        }
+
+        queue.push_back(nodeId);
+    }
+
+    // Check if a triangle contains the newly added point in it's circumcircle
+    // If it does it will also add it's neighbours to the queue so they can also be checked later on
+    // The triangle containing the point is always bad, so forceBad skips the (inexact) test for it
+    bool CheckBadTriangle(int nodeId, int pointId, bool forceBad = false)
+    {
+        if (nodeId == -1) {
+            return false;
+        }
+
+        if (owners != NULL && !owners->Claim(nodeId, ownerId)) {
+            claimFailed = true;
+            return false;
+        }
+
+        int p1Id = triangulation.nodes[nodeId].points[0];
+        int p2Id = triangulation.nodes[nodeId].points[1];
+        int p3Id = triangulation.nodes[nodeId].points[2];
+
+        Vector3 p1, p2, p3;
+        p1 = triangulation.points[p1Id];
+        p2 = triangulation.points[p2Id];
+        p3 = triangulation.points[p3Id];
+
+        bool insideCircumcircle = forceBad || filtered.InCircle(p1, p2, p3, triangulation.points[pointId]);
+
+        if (!insideCircumcircle) {
+            // not a bad triangle so we don't care
+            return false;
+        }
+
+        // This is a bad triangle so we need to add it's neighbours to the queue
+        badTriangles.push_back(nodeId);
+        TriangulationNode node = triangulation.nodes[nodeId];
+        AddQueueNode(node.neighbours[0], node.points[1], node.points[2]);
+        AddQueueNode(node.neighbours[1], node.points[2], node.points[0]);
+        AddQueueNode(node.neighbours[2], node.points[0], node.points[1]);
+
+        return true;
+    }
+
+    // During retriangulation one border point will always have two triangles using it so
+    // we store this to be able to reconstruct neighbours
+    void AddPointTriangle(int pointId, int triangleId)
+    {
+        if (pointTriangles[pointId].first == -1) {
+            pointTriangles[pointId].first = triangleId;
+        } else {
+            pointTriangles[pointId].second = triangleId;
+        }
+    }
+
+    // Link two newly added triangles that have a common edge
+    void LinkPointTriangles(int pointId)
+    {
+        int t1 = pointTriangles[pointId].first;
+        int t2 = pointTriangles[pointId].second;
+
+        if (t1 == -1 || t2 == -1) {
+            return;
+        }
+
+        // We know points[0] is the newly added point for both triangles
+        // so we only check points[1] and points[2] to see where we should add the neighbour
+        if (triangulation.nodes[t1].points[1] == pointId) {
+            triangulation.nodes[t1].neighbours[2] = t2;
+        } else {
+            triangulation.nodes[t1].neighbours[1] = t2;
+        }
+
+        if (triangulation.nodes[t2].points[1] == pointId) {
+            triangulation.nodes[t2].neighbours[2] = t1;
+        } else {
+            triangulation.nodes[t2].neighbours[1] = t1;
+        }
+    }
+
+    // Grows the work vectors so they can be indexed by any node / point of the triangulation
+    void ReserveWorkspace()
+    {
+        // Every insertion adds 2 triangles so leave some room before growing again
+        if (visitedNodes.size() < triangulation.nodes.size() + 2) {
+            visitedNodes.resize(triangulation.nodes.size() * 2 + 2, 0);
+        }
+
+        if (pointTriangles.size() < triangulation.points.size()) {
+            pointTriangles.resize(triangulation.points.size(), make_pair(-1, -1));
+        }
+    }
+
+    // Fills badTriangles with the triangles that have to be removed when adding pointId and edges with
+    // the border of the polygon-hole they leave behind. nodeId is the triangle containing the point
+    // Returns false if the cavity can't be used: a node is owned by another worker (claimFailed), or the point
+    // doesn't see the whole border and the cavity can't grow without getting a hole
+    bool FindCavity(int nodeId, int pointId)
+    {
+        // Starting from this triangle we go through it's neighbours to find all the
+        // triangles containing this point in it's circumcircle
+        visitedNodes[nodeId] = 1;
+        claimFailed = false;
+        CheckBadTriangle(nodeId, pointId, true);
+
+        int queuePos = 0;
+        bool starShaped = false;
+        while (!starShaped && !claimFailed) {
+            for (; queuePos < queue.size(); queuePos++)
+            {
+                bool bad = CheckBadTriangle(queue[queuePos], pointId);
+                if (!bad)
+                {
+                    if (queue[queuePos] != -1) {
+                        // Mark this triangle as a good triangle
+                        // This means this is triangle is a good triangle and it has bad triangle as a neighbour
+                        visitedNodes[queue[queuePos]] = 2;
+                    }
+                }
+            }
+
+            // Go through all the bad triangles and see if they have any good neighbours
+            starShaped = true;
+            edges.clear();
+            for (int i = 0; i < badTriangles.size() && starShaped; i++) {
+                int badTriangle = badTriangles[i];
+                for (int x = 0; x < 3; x++) {
+                    int neighbour = triangulation.nodes[badTriangle].neighbours[x];
+                    if (neighbour == -1 || visitedNodes[neighbour] == 2) {
+                        // Neighbour is a good triangle so add the edge to the list
+                        PolygonEdge edge = PolygonEdge();
+                        edge.nodeId = neighbour;
+                        edge.p1 = triangulation.nodes[badTriangle].points[(x + 1) % 3];
+                        edge.p2 = triangulation.nodes[badTriangle].points[(x + 2) % 3];
+
+                        // Should the filter leave an edge the point doesn't see, it would give a flipped triangle
+                        // Remove the triangle behind it as well, unless that would leave a hole in the cavity
+                        Vector3 p1 = triangulation.points[edge.p1];
+                        Vector3 p2 = triangulation.points[edge.p2];
+                        if (neighbour != -1 && filtered.Orient(triangulation.points[pointId], p1, p2) <= 0) {
+                            if (!KeepsCavitySimple(neighbour, edge.p1, edge.p2)) {
+                                return false;
+                            }
+
+                            visitedNodes[neighbour] = 1;
+                            CheckBadTriangle(neighbour, pointId, true);
+                            starShaped = false;
+                            break;
+                        }
+
+                        edges.push_back(edge);
+                    }
+                }
+            }
+        }
+
+        return !claimFailed;
+    }
+
+    // True if adding the node behind the cavity edge p1-p2 leaves the cavity without holes: the third point of
+    // the node is new to the cavity, or the node touches the cavity along one of its other edges too
+    bool KeepsCavitySimple(int nodeId, int p1, int p2)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        int apex = -1;
+        for (int x = 0; x < 3; x++) {
+            if (node.points[x] != p1 && node.points[x] != p2) {
+                apex = node.points[x];
+            } else if (node.neighbours[x] != -1 && visitedNodes[node.neighbours[x]] == 1) {
+                return true;
+            }
+        }
+
+        for (int i = 0; i < badTriangles.size(); i++) {
+            TriangulationNode& bad = triangulation.nodes[badTriangles[i]];
+            if (bad.points[0] == apex || bad.points[1] == apex || bad.points[2] == apex) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Returns the point of the node in the same place as pointId, or -1 if there is none
+    int FindDuplicate(int nodeId, int pointId)
+    {
+        for (int x = 0; x < 3; x++) {
+            if (GetDistance(triangulation.points[triangulation.nodes[nodeId].points[x]],
+                            triangulation.points[pointId]) < EPS) {
+                return triangulation.nodes[nodeId].points[x];
+            }
+        }
+
+        return -1;
+    }
+
+    bool IsDuplicate(int nodeId, int pointId)
+    {
+        return FindDuplicate(nodeId, pointId) != -1;
+    }
+
+    // Replaces the triangles found by FindCavity with triangles connecting pointId to the border
+    // of the polygon-hole. The ids of the new triangles are stored in newTriangles
+    void FillCavity(int pointId)
+    {
+        newTriangles.clear();
+
+        // Go through the edges of the polygon-hole and add the new triangles
+        // We are reusing the old bad-triangles as spots for the new triangles
+        int crtPos = 0;
+        for (int i = 0; i < edges.size(); i++) {
+            // Add triangle edge.first, edge.second, pointId
+            int triangleId;
+            if (crtPos >= badTriangles.size() && !freeNodes.empty()) {
+                triangleId = freeNodes.back();
+                freeNodes.pop_back();
+            } else if (crtPos >= badTriangles.size()) {
+                // We finished using the badtriangles so we need to add new triangles
+                TriangulationNode node = TriangulationNode();
+                triangleId = triangulation.AddNode(node);
+            } else {
+                triangleId = badTriangles[crtPos];
+                crtPos++;
+            }
+            newTriangles.push_back(triangleId);
+
+            int p1 = edges[i].p1;
+            int p2 = edges[i].p2;
+            triangulation.EditNode(triangleId, pointId, p1, p2, edges[i].nodeId, -1, -1);
+
+            // Add the neigbour from the outer edge
+            int neighbourId = edges[i].nodeId;
+            if (neighbourId != -1)
+            {
+                for (int x = 0; x < 3; x++) {
+                    if (triangulation.nodes[neighbourId].points[x] != p1 &&
+                        triangulation.nodes[neighbourId].points[x] != p2) {
+                        triangulation.nodes[neighbourId].neighbours[x] = triangleId;
+                    }
+                }
+            }
+
+            // Store that this triangle uses the edge p1-point and p2-point
+            // This will be used to link the newly added triangles among them as neighbours
+            AddPointTriangle(p1, triangleId);
+            AddPointTriangle(p2, triangleId);
+        }
+
+        for (int i = 0; i < edges.size(); i++) {
+            // For every edge from point to a edgepoint we link the two triangles using that edge as neighbours
+            LinkPointTriangles(edges[i].p1);
+            LinkPointTriangles(edges[i].p2);
+
+            // Also clean after ourselves
+            pointTriangles[edges[i].p1] = make_pair(-1, -1);
+            pointTriangles[edges[i].p2] = make_pair(-1, -1);
+        }
+
+        // The next point is most likely close to this one so start walking from here
+        lastNode = newTriangles[0];
+
+        ClearCavity();
+    }
+
+    // Forgets the cavity found by FindCavity without changing the triangulation
+    void ClearCavity()
+    {
+        // Cleanup (note we only clean what we used, otherwise we increase time complexity to N^2)
+        for (int i = 0; i < queue.size(); i++) {
+            if (queue[i] == -1) {
+                continue;
+            }
+
+            visitedNodes[queue[i]] = 0;
+        }
+
+        // The first bad triangle is the one containing the point, which is never added to the queue
+        if (!badTriangles.empty()) {
+            visitedNodes[badTriangles[0]] = 0;
+        }
+
+        badTriangles.clear();
+        edges.clear();
+        queue.clear();
+    }
+
+    void AddPointAndRetriangulate(int pointId)
+    {
+        ReserveWorkspace();
+
+        // Find the triangle containint this point
+        int nodeId = triangulation.JumpAndWalk(triangulation.points[pointId], lastNode, filtered);
+
+        // Duplicated points would only create degenerate triangles so they are left out
+        // Same for points outside the triangulation
+        newTriangles.clear();
+        if (nodeId == -1) {
+            skippedPoints.push_back(pointId);
+            return;
+        }
+        if (IsDuplicate(nodeId, pointId)) {
+            duplicatePoints.push_back(pointId);
+            return;
+        }
+
+        if (!FindCavity(nodeId, pointId)) {
+            ClearCavity();
+            skippedPoints.push_back(pointId);
+            return;
+        }
+        FillCavity(pointId);
+    }
+
+    // Inserts a batch of points already added to the triangulation. They are inserted along a hilbert
+    // curve so every walk starts next to the point it looks for, and the work vectors grow only once
+    void AddPointsAndRetriangulate(vector<int> pointIds)
+    {
+        SpatialSort(triangulation.points, pointIds);
+
+        // Every insertion adds 2 nodes
+        triangulation.nodes.reserve(triangulation.nodes.size() + 2 * pointIds.size());
+        visitedNodes.resize(max(visitedNodes.size(), triangulation.nodes.capacity()), 0);
+        ReserveWorkspace();
+
+        for (int i = 0; i < pointIds.size(); i++) {
+            AddPointAndRetriangulate(pointIds[i]);
+        }
+    }
+};
+
+#endif
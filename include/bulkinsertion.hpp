@@ -0,0 +1,188 @@
+#ifndef __BULKINSERTION__H
+#define __BULKINSERTION__H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+// Inserts batches of points into an existing triangulation with several workers at the same time
+// The sorted batch is split in one contiguous block per worker, so the workers start in different
+// regions of the mesh. The insertion goes in rounds: in every round each worker inserts up to roundSize
+// points of its block, claiming every node it reads. Cavities of different workers never overlap, so
+// once a worker runs into a node claimed by someone else it stops and its point is inserted after the
+// round, on a single thread
+// Note the points outside the triangulation are left out (see BowyerWatson::skippedPoints), so keep the super
+// triangle until the end
+template <typename Kernel = DefaultKernel>
+class BulkInsertion {
+public:
+    BowyerWatson<Kernel>& bowyerWatson;
+    Triangulation& triangulation;
+    int workersCnt;
+    int roundSize;
+
+    BulkInsertion(BowyerWatson<Kernel>& _bowyerWatson, int _workersCnt = ThreadsCount(), int _roundSize = 256) :
+        bowyerWatson(_bowyerWatson), triangulation(_bowyerWatson.triangulation),
+        workersCnt(min(_workersCnt, (int)NodeOwners::MAX_WORKERS)), roundSize(_roundSize) {};
+
+    // Inserts the points (already added to the triangulation) with the given ids
+    void AddPoints(vector<int> pointIds)
+    {
+        // Not worth splitting, the serial version doesn't pay for the rounds
+        if (workersCnt <= 1 || pointIds.size() < workersCnt * roundSize) {
+            bowyerWatson.AddPointsAndRetriangulate(pointIds);
+            return;
+        }
+
+        SpatialSort(triangulation.points, pointIds);
+
+        // Workers keep their work vectors between batches
+        while (workers.size() < workersCnt) {
+            workers.push_back(BowyerWatson<Kernel>(triangulation, bowyerWatson.kernel));
+            workers.back().owners = &owners;
+            workers.back().ownerId = workers.size() - 1;
+        }
+
+        vector<int> next(workersCnt), end(workersCnt);
+        vector<char> blocked(workersCnt);
+        int blockSize = (pointIds.size() + workersCnt - 1) / workersCnt;
+        for (int w = 0; w < workersCnt; w++) {
+            next[w] = min((int)pointIds.size(), w * blockSize);
+            end[w] = min((int)pointIds.size(), (w + 1) * blockSize);
+            workers[w].lastNode = bowyerWatson.lastNode;
+        }
+
+        bool done = false;
+        while (!done) {
+            // Every insertion needs 2 new nodes, they are added up front so the workers never grow the nodes
+            for (int w = 0; w < workersCnt; w++) {
+                while (workers[w].freeNodes.size() < 2 * roundSize) {
+                    workers[w].freeNodes.push_back(triangulation.AddNode(TriangulationNode()));
+                }
+            }
+
+            owners.NextRound();
+            owners.Resize(triangulation.nodes.size());
+            for (int w = 0; w < workersCnt; w++) {
+                workers[w].ReserveWorkspace();
+            }
+
+            vector<thread> threads;
+            for (int w = 0; w < workersCnt; w++) {
+                threads.push_back(thread([this, w, &pointIds, &next, &end, &blocked] {
+                    blocked[w] = false;
+                    for (int i = 0; i < roundSize && next[w] < end[w] && !blocked[w]; i++) {
+                        if (InsertPoint(workers[w], pointIds[next[w]])) {
+                            next[w]++;
+                        } else {
+                            blocked[w] = true;
+                        }
+                    }
+                }));
+            }
+
+            for (int w = 0; w < workersCnt; w++) {
+                threads[w].join();
+            }
+
+            // The blocked points are inserted one by one so every round makes progress
+            done = true;
+            for (int w = 0; w < workersCnt; w++) {
+                if (blocked[w]) {
+                    workers[w].ReserveWorkspace();
+                    workers[w].owners = NULL;
+                    InsertPoint(workers[w], pointIds[next[w]]);
+                    workers[w].owners = &owners;
+                    next[w]++;
+                }
+
+                done &= next[w] == end[w];
+            }
+        }
+
+        // Drop the nodes that were added up front but never used, the highest ids first so the node
+        // moved in place of a free one is always in use. The points left out are reported by bowyerWatson
+        vector<int> unused;
+        for (int w = 0; w < workersCnt; w++) {
+            unused.insert(unused.end(), workers[w].freeNodes.begin(), workers[w].freeNodes.end());
+            workers[w].freeNodes.clear();
+
+            BowyerWatson<Kernel>& worker = workers[w];
+            bowyerWatson.skippedPoints.insert(bowyerWatson.skippedPoints.end(), worker.skippedPoints.begin(),
+                                              worker.skippedPoints.end());
+            bowyerWatson.duplicatePoints.insert(bowyerWatson.duplicatePoints.end(), worker.duplicatePoints.begin(),
+                                                worker.duplicatePoints.end());
+            worker.skippedPoints.clear();
+            worker.duplicatePoints.clear();
+        }
+        sort(unused.begin(), unused.end(), greater<int>());
+
+        bowyerWatson.lastNode = workers[0].lastNode;
+        for (int i = 0; i < unused.size(); i++) {
+            int movedId = triangulation.RemoveUnusedNode(unused[i]);
+            if (bowyerWatson.lastNode == movedId) {
+                bowyerWatson.lastNode = unused[i];
+            }
+        }
+    }
+
+private:
+    vector<BowyerWatson<Kernel>> workers;
+    NodeOwners owners;
+
+    // Inserts the point with the given worker. Returns false, without changing the triangulation,
+    // if the worker would need a node owned by another worker
+    bool InsertPoint(BowyerWatson<Kernel>& worker, int pointId)
+    {
+        Vector3 point = triangulation.points[pointId];
+        int nodeId = worker.lastNode;
+        unsigned int seed = 1;
+        while (nodeId != -1) {
+            if (worker.owners != NULL && !worker.owners->Claim(nodeId, worker.ownerId)) {
+                return false;
+            }
+
+            int edge = triangulation.WalkStep(nodeId, point, worker.filtered, seed);
+            if (edge == -1) {
+                break;
+            }
+            nodeId = triangulation.nodes[nodeId].neighbours[edge];
+        }
+
+        if (nodeId == -1) {
+            worker.skippedPoints.push_back(pointId);
+            return true;
+        }
+        if (worker.IsDuplicate(nodeId, pointId)) {
+            worker.duplicatePoints.push_back(pointId);
+            return true;
+        }
+
+        if (!worker.FindCavity(nodeId, pointId) && !worker.claimFailed) {
+            // Not because of another worker, the point can't be inserted at all
+            worker.ClearCavity();
+            worker.skippedPoints.push_back(pointId);
+            return true;
+        }
+
+        // A normal cavity needs 2 nodes more than it frees
+        int neededNodes = (int)worker.edges.size() - (int)worker.badTriangles.size();
+        if (worker.claimFailed || (worker.owners != NULL && neededNodes > (int)worker.freeNodes.size())) {
+            worker.ClearCavity();
+            return false;
+        }
+
+        worker.FillCavity(pointId);
+        return true;
+    }
+};
+
+#endif
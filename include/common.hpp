@@ -4,6 +4,7 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 const double EPS = 0.0001;
 
@@ -31,6 +32,11 @@ Vector3 operator+(Vector3 lhs, const Vector3& rhs)
     return Vector3(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z);
 }
 
+Vector3 operator-(Vector3 lhs, const Vector3& rhs)
+{
+    return Vector3(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z);
+}
+
 Vector3 operator*(Vector3 lhs, const double alpha)
 {
     return Vector3(lhs.x * alpha, lhs.y * alpha, lhs.z * alpha);
@@ -38,7 +44,7 @@ Vector3 operator*(Vector3 lhs, const double alpha)
 
 
 // Returns the distance between two points
-double GetDistance(Vector3 p1, Vector3 p2) {
+double GetDistance(const Vector3& p1, const Vector3& p2) {
     return sqrt((p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y));
 }
 
@@ -46,84 +52,12 @@ double GetDistance(Vector3 p1, Vector3 p2) {
  * - if negative points are in clocwise order, counterclockwise order otherwise
  * - absolute value is double the area of the triangle defined by p1, p2 and p3
  */
-double det(Vector3 p1, Vector3 p2, Vector3 p3)
+double det(const Vector3& p1, const Vector3& p2, const Vector3& p3)
 {
     return p1.x * p2.y + p2.x * p3.y + p3.x * p1.y -
            p1.x * p3.y - p3.x * p2.y - p2.x * p1.y;
 }
 
-// Comparison method for sorting points by x, and by y in case of equality
-int ConvexHullCMP(pair<Vector3, int> p1, pair<Vector3, int> p2)
-{
-    if (p1.first.x == p2.first.x) {
-        return p1.first.y < p2.first.y;
-    }
-
-    return p1.first.x < p2.first.x;
-}
-
-// Returns a vector of indices of the points on the convex hull of the points 
-// received as argument
-vector<int> ComputeConvexHull(vector<Vector3> points)
-{
-    vector<pair<Vector3, int>> sortedPoints;
-    for (int i = 0; i < points.size(); i++) {
-        sortedPoints.push_back(make_pair(points[i], i));
-    }
-
-    sort(sortedPoints.begin(), sortedPoints.end(), ConvexHullCMP);
-
-    vector<int> st;
-    // Bottom Part of convex hull
-    int stackLimit = 2;
-    for (int i = 0; i < sortedPoints.size(); i++) {
-        bool ccwAngle = false;
-        while (!ccwAngle && st.size() >= stackLimit)
-        {
-            ccwAngle = true;
-            Vector3 p1 = sortedPoints[st[st.size() - 2]].first;
-            Vector3 p2 = sortedPoints[st[st.size() - 1]].first;
-            Vector3 p3 = sortedPoints[i].first;
-
-            if (det(p1, p2, p3) < EPS) {
-                st.pop_back();
-                ccwAngle = false;
-            }
-        }
-
-        st.push_back(i); 
-    }
-
-    // This is to make sure we don't remove points from the bottom part
-    stackLimit = st.size() + 1;
-    // Top part of convex hull
-    for (int i = sortedPoints.size() - 2; i >= 0; i--) {
-        bool ccwAngle = false;
-        while (!ccwAngle && st.size() >= stackLimit)
-        {
-            ccwAngle = true;
-            Vector3 p1 = sortedPoints[st[st.size() - 2]].first;
-            Vector3 p2 = sortedPoints[st[st.size() - 1]].first;
-            Vector3 p3 = sortedPoints[i].first;
-
-            if (det(p1, p2, p3) < EPS) {
-                st.pop_back();
-                ccwAngle = false;
-            }
-        }
-        st.push_back(i); 
-    }
-
-    // First element is added twice so pop it
-    st.pop_back();
-
-    vector<int> ret;
-    for (int i = 0; i < st.size(); i++) {
-        ret.push_back(sortedPoints[st[i]].second);
-    }
-    return ret;
-}
-
 // Checks if point p is inside triangle p1, p2, p3 by using barycentric coordinates
 bool InsideTriangle(Vector3 p1, Vector3 p2, Vector3 p3, Vector3 p)
 {
@@ -181,6 +115,20 @@ bool InsideTriangleCircumcircle(Vector3 p1, Vector3 p2, Vector3 p3, Vector3 poin
     return detVal > EPS;
 }
 
+// Returns the center of the circle passing through p1, p2 and p3
+// Note this assumes the points are not collinear
+Vector3 Circumcenter(Vector3 p1, Vector3 p2, Vector3 p3)
+{
+    // Work relative to p1 to keep the products small
+    double bx = p2.x - p1.x, by = p2.y - p1.y;
+    double cx = p3.x - p1.x, cy = p3.y - p1.y;
+    double d = 2 * (bx * cy - by * cx);
+    double b2 = bx * bx + by * by;
+    double c2 = cx * cx + cy * cy;
+
+    return Vector3(p1.x + (cy * b2 - by * c2) / d, p1.y + (bx * c2 - cx * b2) / d, 0);
+}
+
 bool BoundingBoxIntersect(Vector3 b1, Vector3 b2, Vector3 b3, Vector3 b4)
 {
     if ((b1.x < b4.x && b2.x > b3.x) &&
@@ -216,4 +164,62 @@ bool SegmentIntersect(Vector3 p1, Vector3 p2, Vector3 p3, Vector3 p4)
     return false;
 }
 
+// Returns the position of the cell (x, y) along a hilbert curve covering a 2^order x 2^order grid
+long long HilbertIndex(int order, int x, int y)
+{
+    long long index = 0;
+    for (int s = (1 << (order - 1)); s > 0; s /= 2) {
+        int rx = (x & s) > 0;
+        int ry = (y & s) > 0;
+        index += (long long)s * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so the curve stays continuous
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            int aux = x;
+            x = y;
+            y = aux;
+        }
+    }
+
+    return index;
+}
+
+// Sorts the point ids so that points close to each other in the plane are close to each other
+// in the list as well. Inserting points in this order keeps the walks between insertions short
+void SpatialSort(const vector<Vector3>& points, vector<int>& ids)
+{
+    if (ids.empty()) {
+        return;
+    }
+
+    double minX = points[ids[0]].x, maxX = points[ids[0]].x;
+    double minY = points[ids[0]].y, maxY = points[ids[0]].y;
+    for (int i = 0; i < ids.size(); i++) {
+        minX = min(minX, points[ids[i]].x);
+        maxX = max(maxX, points[ids[i]].x);
+        minY = min(minY, points[ids[i]].y);
+        maxY = max(maxY, points[ids[i]].y);
+    }
+
+    const int order = 16;
+    double cells = (1 << order) - 1;
+    double scale = cells / max(max(maxX - minX, maxY - minY), EPS);
+
+    vector<pair<long long, int>> keys(ids.size());
+    for (int i = 0; i < ids.size(); i++) {
+        int x = (int)((points[ids[i]].x - minX) * scale);
+        int y = (int)((points[ids[i]].y - minY) * scale);
+        keys[i] = make_pair(HilbertIndex(order, x, y), ids[i]);
+    }
+
+    sort(keys.begin(), keys.end());
+    for (int i = 0; i < ids.size(); i++) {
+        ids[i] = keys[i].second;
+    }
+}
+
 #endif
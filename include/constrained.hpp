@@ -0,0 +1,497 @@
+#ifndef __CONSTRAINED__H
+#define __CONSTRAINED__H
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "kernel.hpp"
+
+using namespace std;
+
+// Why the last InsertConstraint left its segment out
+enum ConstraintError {
+    CONSTRAINT_INSERTED,
+    // A point id out of range, or a point that isn't in the triangulation (ex. a duplicate left out)
+    CONSTRAINT_MISSING_POINT,
+    // The segment crosses another constrained edge
+    CONSTRAINT_CROSSES_SEGMENT,
+    // The segment goes out of the triangulation
+    CONSTRAINT_OUTSIDE
+};
+
+// Constrained delaunay triangulation on top of an existing (counterclockwise) triangulation
+// Constrained edges are kept as edges of the triangulation and never flipped, every other edge stays
+// delaunay. Every edit only touches the triangles around the segment, so editing obstacles of a big map
+// stays cheap
+// Note BowyerWatson doesn't know about the constraints, so insert the points before the segments
+template <typename Kernel = DefaultKernel>
+class ConstrainedDelaunay {
+public:
+    Triangulation& triangulation;
+    Kernel kernel;
+
+    // Node used as the starting point of the next walk, next to the last point found
+    int lastNode;
+
+    // Why the last InsertConstraint failed
+    ConstraintError error;
+
+    ConstrainedDelaunay(Triangulation& _triangulation, Kernel _kernel = Kernel()) :
+        triangulation(_triangulation), kernel(_kernel), lastNode(0), error(CONSTRAINT_INSERTED) {};
+
+    // Makes the segment p1-p2 an edge of the triangulation that is never flipped
+    // Points right on the segment split it in several constrained edges
+    // Returns false, without changing anything, if one of the points isn't in the triangulation, or the segment
+    // crosses another constrained edge or leaves the triangulation (see error)
+    bool InsertConstraint(int p1, int p2)
+    {
+        error = CONSTRAINT_INSERTED;
+        int pointsCnt = triangulation.points.size();
+        if (p1 < 0 || p1 >= pointsCnt || p2 < 0 || p2 >= pointsCnt) {
+            error = CONSTRAINT_MISSING_POINT;
+            return false;
+        }
+
+        // Check the whole segment before editing, so a failed insertion leaves the mesh as it was
+        // Every piece ends next to the start of the next one, only the first point needs a walk
+        int firstNode = FindPointNode(p1);
+        vector<int> pieces;
+        int a = p1;
+        while (a != p2) {
+            int b = FindCrossedTriangles(a, p2);
+            if (b == -1) {
+                // The segment can't reach p2 if it isn't there
+                if (error == CONSTRAINT_OUTSIDE && FindPointNode(p2) == -1) {
+                    error = CONSTRAINT_MISSING_POINT;
+                }
+                return false;
+            }
+
+            pieces.push_back(a);
+            a = b;
+        }
+        pieces.push_back(p2);
+
+        lastNode = firstNode;
+        for (int i = 0; i + 1 < pieces.size(); i++) {
+            FindCrossedTriangles(pieces[i], pieces[i + 1]);
+            if (!crossedNodes.empty()) {
+                Retriangulate(pieces[i], pieces[i + 1]);
+            }
+            triangulation.SetConstrained(pieces[i], pieces[i + 1], true);
+        }
+
+        return true;
+    }
+
+    // Removes the constraint from the edge p1-p2 and flips the edges around it until they are delaunay
+    void RemoveConstraint(int p1, int p2)
+    {
+        triangulation.SetConstrained(p1, p2, false);
+
+        int nodeId = FindEdgeNode(p1, p2);
+        if (nodeId != -1) {
+            TriangulationNode& node = triangulation.nodes[nodeId];
+            for (int x = 0; x < 3; x++) {
+                if (node.points[x] != p1 && node.points[x] != p2) {
+                    flipQueue.push_back(make_pair(nodeId, x));
+                }
+            }
+            LegalizeEdges();
+        }
+    }
+
+    // Flips the edge opposite to points[x] in the node, keeping both triangles counterclockwise
+    // Returns false if the two triangles don't form a convex quad
+    bool FlipEdge(int t1, int x)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        int t2 = nodes[t1].neighbours[x];
+        int p = nodes[t1].points[x];
+        int q = nodes[t1].points[(x + 1) % 3];
+        int r = nodes[t1].points[(x + 2) % 3];
+        int nq = nodes[t1].neighbours[(x + 1) % 3];
+        int nr = nodes[t1].neighbours[(x + 2) % 3];
+
+        int y = LocalIndex(nodes[t2], q);
+        y = (y + 1) % 3;
+        int s = nodes[t2].points[y];
+        int mr = nodes[t2].neighbours[(y + 1) % 3];
+        int mq = nodes[t2].neighbours[(y + 2) % 3];
+
+        vector<Vector3>& points = triangulation.points;
+        if (kernel.Orient(points[p], points[q], points[s]) <= 0 ||
+            kernel.Orient(points[p], points[s], points[r]) <= 0) {
+            return false;
+        }
+
+        triangulation.EditNode(t1, p, q, s, mr, t2, nr);
+        triangulation.EditNode(t2, p, s, r, mq, nq, t1);
+        triangulation.EditNodeEdge(mr, q, s, t1);
+        triangulation.EditNodeEdge(nq, r, p, t2);
+        return true;
+    }
+
+    // Pending edges (node, index of the opposite point) checked by LegalizeEdges
+    vector<pair<int, int>> flipQueue;
+
+    // Flips the queued edges that aren't delaunay, and the edges around them, until there is none left
+    // Constrained edges are skipped
+    void LegalizeEdges()
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        while (!flipQueue.empty()) {
+            int nodeId = flipQueue.back().first;
+            int x = flipQueue.back().second;
+            flipQueue.pop_back();
+
+            int neighbour = nodes[nodeId].neighbours[x];
+            int q = nodes[nodeId].points[(x + 1) % 3];
+            int r = nodes[nodeId].points[(x + 2) % 3];
+            if (neighbour == -1 || triangulation.IsConstrained(q, r)) {
+                continue;
+            }
+
+            int s = nodes[neighbour].points[(LocalIndex(nodes[neighbour], q) + 1) % 3];
+            if (!kernel.InCircle(points[nodes[nodeId].points[0]], points[nodes[nodeId].points[1]],
+                                 points[nodes[nodeId].points[2]], points[s])) {
+                continue;
+            }
+
+            if (FlipEdge(nodeId, x)) {
+                // The 4 edges of the quad might not be delaunay anymore
+                flipQueue.push_back(make_pair(nodeId, 0));
+                flipQueue.push_back(make_pair(nodeId, 2));
+                flipQueue.push_back(make_pair(neighbour, 0));
+                flipQueue.push_back(make_pair(neighbour, 1));
+            }
+        }
+    }
+
+    // Node ids left over by ReplaceNodes, used first by the next replacements
+    vector<int> freeNodes;
+
+    // Replaces the nodes of a region with the given triangles (3 point ids each, counterclockwise) covering
+    // the same area, and links them with each other and with the nodes around the region
+    void ReplaceNodes(const vector<int>& region, const vector<int>& triangles)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+
+        // Edges of the region seen twice are inside it, the others are on its border
+        borderNeighbours.clear();
+        for (int i = 0; i < region.size(); i++) {
+            TriangulationNode& node = nodes[region[i]];
+            for (int x = 0; x < 3; x++) {
+                long long key = Triangulation::EdgeKey(node.points[(x + 1) % 3], node.points[(x + 2) % 3]);
+                if (borderNeighbours.count(key)) {
+                    borderNeighbours.erase(key);
+                } else {
+                    borderNeighbours[key] = node.neighbours[x];
+                }
+            }
+        }
+
+        for (int i = triangles.size() / 3; i < region.size(); i++) {
+            freeNodes.push_back(region[i]);
+        }
+
+        newEdges.clear();
+        for (int i = 0; i < triangles.size(); i += 3) {
+            int nodeId;
+            if (i / 3 < region.size()) {
+                nodeId = region[i / 3];
+            } else if (!freeNodes.empty()) {
+                nodeId = freeNodes.back();
+                freeNodes.pop_back();
+            } else {
+                nodeId = triangulation.AddNode(TriangulationNode());
+            }
+            triangulation.EditNode(nodeId, triangles[i], triangles[i + 1], triangles[i + 2], -1, -1, -1);
+            lastNode = nodeId;
+
+            for (int x = 0; x < 3; x++) {
+                int p1 = nodes[nodeId].points[(x + 1) % 3];
+                int p2 = nodes[nodeId].points[(x + 2) % 3];
+                long long key = Triangulation::EdgeKey(p1, p2);
+
+                unordered_map<long long, int>::iterator border = borderNeighbours.find(key);
+                unordered_map<long long, int>::iterator other = newEdges.find(key);
+                if (border != borderNeighbours.end()) {
+                    nodes[nodeId].neighbours[x] = border->second;
+                    triangulation.EditNodeEdge(border->second, p1, p2, nodeId);
+                } else if (other != newEdges.end()) {
+                    nodes[nodeId].neighbours[x] = other->second;
+                    triangulation.EditNodeEdge(other->second, p1, p2, nodeId);
+                } else {
+                    newEdges[key] = nodeId;
+                }
+            }
+        }
+    }
+
+    // Returns a node having pointId as one of its points, or -1 if the point isn't in the triangulation
+    // The last node found is often next to the point (the next piece of a segment, or of a polyline), the walk
+    // is only needed when it isn't
+    int FindPointNode(int pointId)
+    {
+        if (lastNode < 0 || lastNode >= triangulation.nodes.size()) {
+            lastNode = 0;
+        }
+
+        int nodeId = FindAround(lastNode, pointId);
+        if (nodeId == -1) {
+            nodeId = triangulation.JumpAndWalk(triangulation.points[pointId], lastNode, kernel);
+            if (nodeId == -1) {
+                return -1;
+            }
+
+            // With the EPS tolerances the walk can stop in a triangle next to the point, so look around it
+            nodeId = FindAround(nodeId, pointId);
+        }
+
+        if (nodeId != -1) {
+            lastNode = nodeId;
+        }
+        return nodeId;
+    }
+
+    static int LocalIndex(const TriangulationNode& node, int pointId)
+    {
+        for (int x = 0; x < 3; x++) {
+            if (node.points[x] == pointId) {
+                return x;
+            }
+        }
+
+        return -1;
+    }
+
+private:
+    // Looks for a node having pointId among the 16 nodes around nodeId, -1 if none of them has it
+    int FindAround(int nodeId, int pointId)
+    {
+        if (triangulation.nodes.empty()) {
+            return -1;
+        }
+
+        vector<int> around(1, nodeId);
+        for (int i = 0; i < around.size() && i < 16; i++) {
+            TriangulationNode& node = triangulation.nodes[around[i]];
+            if (LocalIndex(node, pointId) != -1) {
+                return around[i];
+            }
+
+            for (int x = 0; x < 3; x++) {
+                if (node.neighbours[x] != -1) {
+                    around.push_back(node.neighbours[x]);
+                }
+            }
+        }
+
+        return -1;
+    }
+
+    // Triangles crossed by the current segment, and the points on its two sides in the order they are met
+    vector<int> crossedNodes;
+    vector<int> leftChain;
+    vector<int> rightChain;
+
+    // Outer neighbour of every edge on the border of the crossed triangles
+    unordered_map<long long, int> borderNeighbours;
+    unordered_map<long long, int> newEdges;
+
+    // New triangles, 3 points each
+    vector<int> newTriangles;
+
+    // Returns a node around a having the edge a-b, or -1 if there is no such edge
+    int FindEdgeNode(int a, int b)
+    {
+        int startNode = FindPointNode(a);
+        if (startNode == -1) {
+            return -1;
+        }
+
+        // Go counterclockwise around a, and clockwise if we hit the hull
+        for (int direction = 1; direction <= 2; direction++) {
+            int nodeId = startNode;
+            do {
+                TriangulationNode& node = triangulation.nodes[nodeId];
+                if (LocalIndex(node, b) != -1) {
+                    return nodeId;
+                }
+                nodeId = node.neighbours[(LocalIndex(node, a) + direction) % 3];
+            } while (nodeId != -1 && nodeId != startNode);
+
+            if (nodeId == startNode) {
+                break;
+            }
+        }
+
+        return -1;
+    }
+
+    // Walks from a towards b and fills crossedNodes and the two chains with the triangles crossed by
+    // the segment a-b. The walk stops at b or at the first point right on the segment, which is returned, and
+    // lastNode is left on a node having that point
+    // Returns -1 and sets error if the segment crosses a constrained edge or leaves the triangulation
+    int FindCrossedTriangles(int a, int b)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        crossedNodes.clear();
+        leftChain.clear();
+        rightChain.clear();
+
+        int startNode = FindPointNode(a);
+        if (startNode == -1) {
+            error = CONSTRAINT_MISSING_POINT;
+            return -1;
+        }
+
+        // Find the triangle around a that the segment goes through
+        // Going clockwise as well in case a is on the hull
+        int nodeId = -1;
+        for (int direction = 1; direction <= 2 && nodeId == -1; direction++) {
+            int crt = startNode;
+            do {
+                TriangulationNode& node = nodes[crt];
+                int k = LocalIndex(node, a);
+                int q = node.points[(k + 1) % 3];
+                int r = node.points[(k + 2) % 3];
+
+                // The segment goes along an existing edge
+                if (q == b || r == b) {
+                    lastNode = crt;
+                    return b;
+                }
+
+                int orientQ = kernel.Orient(points[a], points[b], points[q]);
+                int orientR = kernel.Orient(points[a], points[b], points[r]);
+                if (orientQ == 0 && Ahead(a, b, q)) {
+                    lastNode = crt;
+                    return q;
+                }
+                if (orientR == 0 && Ahead(a, b, r)) {
+                    lastNode = crt;
+                    return r;
+                }
+
+                if (orientQ < 0 && orientR > 0) {
+                    nodeId = crt;
+                    break;
+                }
+
+                crt = node.neighbours[(k + direction) % 3];
+            } while (crt != -1 && crt != startNode);
+
+            if (crt == startNode) {
+                break;
+            }
+        }
+
+        if (nodeId == -1) {
+            error = CONSTRAINT_OUTSIDE;
+            return -1;
+        }
+
+        // Cross the triangles one by one, the crossed edge is always right-left
+        TriangulationNode& first = nodes[nodeId];
+        int k = LocalIndex(first, a);
+        int right = first.points[(k + 1) % 3];
+        int left = first.points[(k + 2) % 3];
+        rightChain.push_back(right);
+        leftChain.push_back(left);
+        crossedNodes.push_back(nodeId);
+
+        while (true) {
+            if (triangulation.IsConstrained(right, left)) {
+                error = CONSTRAINT_CROSSES_SEGMENT;
+                return -1;
+            }
+
+            int opposite = 3 - LocalIndex(nodes[nodeId], right) - LocalIndex(nodes[nodeId], left);
+            int next = nodes[nodeId].neighbours[opposite];
+            if (next == -1) {
+                error = CONSTRAINT_OUTSIDE;
+                return -1;
+            }
+
+            nodeId = next;
+            crossedNodes.push_back(nodeId);
+            TriangulationNode& node = nodes[nodeId];
+            int v = -1;
+            for (int y = 0; y < 3; y++) {
+                if (node.points[y] != right && node.points[y] != left) {
+                    v = node.points[y];
+                }
+            }
+
+            int orientV = kernel.Orient(points[a], points[b], points[v]);
+            if (v == b || orientV == 0) {
+                lastNode = nodeId;
+                return v;
+            }
+
+            if (orientV > 0) {
+                leftChain.push_back(v);
+                left = v;
+            } else {
+                rightChain.push_back(v);
+                right = v;
+            }
+        }
+    }
+
+    // True if point is on the same side of a as b
+    bool Ahead(int a, int b, int point)
+    {
+        Vector3 ab = triangulation.points[b] - triangulation.points[a];
+        Vector3 ap = triangulation.points[point] - triangulation.points[a];
+        return ab.x * ap.x + ab.y * ap.y > 0;
+    }
+
+    // Replaces the crossed triangles with the delaunay triangulations of the two pseudo-polygons
+    // on the sides of the edge a-b
+    void Retriangulate(int a, int b)
+    {
+        // Both polygons are walked counterclockwise: a -> b -> left chain back to a, and
+        // b -> a -> right chain back to b
+        newTriangles.clear();
+        reverse(leftChain.begin(), leftChain.end());
+        TriangulatePseudoPolygon(a, b, leftChain, 0, leftChain.size());
+        TriangulatePseudoPolygon(b, a, rightChain, 0, rightChain.size());
+
+        ReplaceNodes(crossedNodes, newTriangles);
+    }
+
+    // Triangulates the counterclockwise polygon a, b, chain[begin], ..., chain[end - 1]. The chain point
+    // making an empty circle with a-b is connected to it and the two smaller polygons are done the same way
+    void TriangulatePseudoPolygon(int a, int b, vector<int>& chain, int begin, int end)
+    {
+        if (begin >= end) {
+            return;
+        }
+
+        vector<Vector3>& points = triangulation.points;
+        int c = begin;
+        for (int i = begin + 1; i < end; i++) {
+            if (kernel.InCircle(points[a], points[b], points[chain[c]], points[chain[i]])) {
+                c = i;
+            }
+        }
+
+        // chain[begin, c) connects b with chain[c], chain(c, end) connects chain[c] with a
+        TriangulatePseudoPolygon(chain[c], b, chain, begin, c);
+        TriangulatePseudoPolygon(a, chain[c], chain, c + 1, end);
+
+        newTriangles.push_back(a);
+        newTriangles.push_back(b);
+        newTriangles.push_back(chain[c]);
+    }
+};
+
+#endif
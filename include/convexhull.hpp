@@ -0,0 +1,176 @@
+#ifndef __CONVEXHULL__H
+#define __CONVEXHULL__H
+
+#include <vector>
+#include <algorithm>
+
+#include "common.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+// Convex hull of a pointset, computed once and kept around
+// The points far from the hull are thrown away before sorting (Akl-Toussaint): the extreme points in
+// 8 directions form an octagon inside the hull and nothing strictly inside it can be on the hull
+class ConvexHull {
+public:
+    // Ids of the points on the hull in counterclockwise order. Points in the middle of a hull edge are only kept
+    // with keepCollinear (ex. to split the boundary into segments that don't pass over points)
+    vector<int> points;
+
+    // membership[i] is true if point i is on the hull. Bytes rather than bits, so it can be read from several
+    // threads and tested without masking
+    vector<char> membership;
+
+    bool keepCollinear;
+
+    ConvexHull(bool _keepCollinear = false) : keepCollinear(_keepCollinear) {};
+
+    // Computes the hull of the first pointsCnt points (all of them if pointsCnt is -1)
+    void Compute(const vector<Vector3>& allPoints, int pointsCnt = -1)
+    {
+        int n = pointsCnt == -1 ? allPoints.size() : pointsCnt;
+        points.clear();
+        membership.assign(n, false);
+        if (n == 0) {
+            return;
+        }
+
+        vector<int> candidates;
+        FilterInterior(allPoints, n, candidates);
+
+        ParallelSort(candidates, [&allPoints](int a, int b) {
+            if (allPoints[a].x == allPoints[b].x) {
+                return allPoints[a].y < allPoints[b].y;
+            }
+
+            return allPoints[a].x < allPoints[b].x;
+        });
+
+        // Monotone chain on the remaining points, bottom part then top part
+        vector<int> st;
+        int stackLimit = 2;
+        for (int i = 0; i < candidates.size(); i++) {
+            PushHullPoint(allPoints, st, candidates[i], stackLimit);
+        }
+
+        // This is to make sure we don't remove points from the bottom part
+        stackLimit = st.size() + 1;
+        for (int i = (int)candidates.size() - 2; i >= 0; i--) {
+            PushHullPoint(allPoints, st, candidates[i], stackLimit);
+        }
+
+        // First point is added twice so pop it
+        if (st.size() > 1) {
+            st.pop_back();
+        }
+
+        // With collinear points kept, all the points on a line come back on the top part, the hull is the chain
+        // from one end to the other
+        if (keepCollinear && st.size() > 2 && st.back() == st[1]) {
+            st.resize(stackLimit - 1);
+        }
+
+        points = st;
+        for (int i = 0; i < points.size(); i++) {
+            membership[points[i]] = true;
+        }
+    }
+
+    bool Contains(int pointId) const
+    {
+        return pointId < membership.size() && membership[pointId];
+    }
+
+private:
+    // Fills candidates with the points that are not strictly inside the octagon of extreme points
+    void FilterInterior(const vector<Vector3>& allPoints, int n, vector<int>& candidates)
+    {
+        // Direction k is at k * 45 degrees, so the extremes go around the pointset counterclockwise
+        const double dirX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+        const double dirY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+        int threadsCnt = ThreadsCount();
+        vector<vector<int>> blockExtremes(threadsCnt, vector<int>(8, -1));
+        ParallelFor(n, [&](int t, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                for (int k = 0; k < 8; k++) {
+                    int& best = blockExtremes[t][k];
+                    if (best == -1 || dirX[k] * allPoints[i].x + dirY[k] * allPoints[i].y >
+                                      dirX[k] * allPoints[best].x + dirY[k] * allPoints[best].y) {
+                        best = i;
+                    }
+                }
+            }
+        });
+
+        vector<int> octagon;
+        for (int k = 0; k < 8; k++) {
+            int best = -1;
+            for (int t = 0; t < threadsCnt; t++) {
+                int crt = blockExtremes[t][k];
+                if (crt != -1 && (best == -1 || dirX[k] * allPoints[crt].x + dirY[k] * allPoints[crt].y >
+                                                dirX[k] * allPoints[best].x + dirY[k] * allPoints[best].y)) {
+                    best = crt;
+                }
+            }
+
+            if (octagon.empty() || octagon.back() != best) {
+                octagon.push_back(best);
+            }
+        }
+        while (octagon.size() > 1 && octagon.back() == octagon[0]) {
+            octagon.pop_back();
+        }
+
+        vector<vector<int>> blockCandidates(threadsCnt);
+        ParallelFor(n, [&](int t, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                bool inside = octagon.size() >= 3;
+                for (int k = 0; k < octagon.size() && inside; k++) {
+                    Vector3 p1 = allPoints[octagon[k]];
+                    Vector3 p2 = allPoints[octagon[(k + 1) % octagon.size()]];
+                    inside = det(p1, p2, allPoints[i]) > EPS;
+                }
+
+                if (!inside) {
+                    blockCandidates[t].push_back(i);
+                }
+            }
+        });
+
+        candidates.clear();
+        for (int t = 0; t < threadsCnt; t++) {
+            candidates.insert(candidates.end(), blockCandidates[t].begin(), blockCandidates[t].end());
+        }
+    }
+
+    // Pops the points that would make a clockwise turn with pointId (or no turn, unless keepCollinear) and
+    // pushes it. With keepCollinear a duplicate of the last point is skipped
+    void PushHullPoint(const vector<Vector3>& allPoints, vector<int>& st, int pointId, int stackLimit)
+    {
+        if (keepCollinear && !st.empty() && allPoints[st.back()].x == allPoints[pointId].x &&
+            allPoints[st.back()].y == allPoints[pointId].y) {
+            return;
+        }
+
+        double limit = keepCollinear ? -EPS : EPS;
+        while (st.size() >= stackLimit &&
+               det(allPoints[st[st.size() - 2]], allPoints[st[st.size() - 1]], allPoints[pointId]) < limit) {
+            st.pop_back();
+        }
+
+        st.push_back(pointId);
+    }
+};
+
+// Returns a vector of indices of the points on the convex hull of the points
+// received as argument
+vector<int> ComputeConvexHull(const vector<Vector3>& points)
+{
+    ConvexHull hull;
+    hull.Compute(points);
+    return hull.points;
+}
+
+#endif
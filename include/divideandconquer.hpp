@@ -0,0 +1,452 @@
+#ifndef __DIVIDEANDCONQUER__H
+#define __DIVIDEANDCONQUER__H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+// Guibas-Stolfi divide and conquer delaunay triangulation, O(N log N) in the worst case
+// The points are split at the median, alternating between x and y cuts (Dwyer), so the halves stay
+// square-ish and the merges stay short even on sorted inputs. The halves are built on their own threads
+// until they get below grainSize points
+// The mesh is built as a quad edge structure and converted to nodes at the end. Every half only touches
+// the edges in its own slice of the edge storage, so the output is the same for any number of threads
+// Note duplicate points are left out of the triangulation
+template <typename Kernel = DefaultKernel>
+class DivideAndConquer {
+public:
+    Triangulation& triangulation;
+    Kernel kernel;
+    int grainSize;
+
+    DivideAndConquer(Triangulation& _triangulation, int _grainSize = 16384, Kernel _kernel = Kernel()) :
+        triangulation(_triangulation), kernel(_kernel), grainSize(_grainSize), filtered(_kernel) {};
+
+    // Replaces the nodes of the triangulation with the delaunay triangulation of all its points
+    void Triangulate()
+    {
+        vector<Vector3>& points = triangulation.points;
+        triangulation.nodes.clear();
+
+        ids.clear();
+        for (int i = 0; i < points.size(); i++) {
+            ids.push_back(i);
+        }
+
+        // Sorting by x first puts the duplicates next to each other, the lowest id is kept
+        ParallelSort(ids, [&points](int a, int b) {
+            if (points[a].x != points[b].x) {
+                return points[a].x < points[b].x;
+            }
+            if (points[a].y != points[b].y) {
+                return points[a].y < points[b].y;
+            }
+
+            return a < b;
+        });
+        int n = 0;
+        for (int i = 0; i < ids.size(); i++) {
+            if (n == 0 || points[ids[i]].x != points[ids[n - 1]].x || points[ids[i]].y != points[ids[n - 1]].y) {
+                ids[n++] = ids[i];
+            }
+        }
+        ids.resize(n);
+        if (n < 2) {
+            return;
+        }
+
+        // A planar graph on n points has at most 3n edges, each half gets 3 edge slots per point
+        next.assign(4 * 3 * n, -1);
+        origin.assign(4 * 3 * n, -1);
+        alive.assign(3 * n, false);
+
+        int parallelDepth = 0;
+        while ((1 << parallelDepth) < ThreadsCount()) {
+            parallelDepth++;
+        }
+
+        // The points are copied in the order of the splits, so every half works on a contiguous block of memory
+        Split(0, n, X_AXIS, parallelDepth);
+        sites.resize(n);
+        for (int i = 0; i < n; i++) {
+            sites[i] = points[ids[i]];
+        }
+
+        int hullEdge = Build(0, n, X_AXIS, parallelDepth);
+        BuildNodes(hullEdge);
+    }
+
+private:
+    static const int X_AXIS = 0;
+    static const int Y_AXIS = 1;
+
+    FilteredKernel<Kernel> filtered;
+
+    // Point ids without duplicates, reordered by the splits, and their points. The mesh is built on the
+    // indices in this order
+    vector<int> ids;
+    vector<Vector3> sites;
+
+    // Quad edges: the directed edge e belongs to the slot e / 4 and e % 4 is its rotation (0 and 2 are the two
+    // directions of the edge, 1 and 3 the dual edges). next is onext, origin is only set for the primal edges
+    vector<int> next;
+    vector<int> origin;
+    vector<char> alive;
+
+    static int Rot(int e) { return (e & ~3) | ((e + 1) & 3); }
+    static int Sym(int e) { return (e & ~3) | ((e + 2) & 3); }
+    static int InvRot(int e) { return (e & ~3) | ((e + 3) & 3); }
+
+    int Onext(int e) { return next[e]; }
+    int Oprev(int e) { return Rot(next[Rot(e)]); }
+    int Lnext(int e) { return Rot(next[InvRot(e)]); }
+    int Rprev(int e) { return next[Sym(e)]; }
+    int Org(int e) { return origin[e]; }
+    int Dest(int e) { return origin[Sym(e)]; }
+
+    // Free edge slots of a subproblem: the slots deleted by the merge first, then the unused ones of its slice
+    struct EdgeSlots {
+        int cursor;
+        vector<int> deleted;
+    };
+
+    int NewSlot(EdgeSlots& slots)
+    {
+        if (!slots.deleted.empty()) {
+            int slot = slots.deleted.back();
+            slots.deleted.pop_back();
+            return slot;
+        }
+
+        while (alive[slots.cursor]) {
+            slots.cursor++;
+        }
+        return slots.cursor++;
+    }
+
+    int MakeEdge(EdgeSlots& slots, int a, int b)
+    {
+        int slot = NewSlot(slots);
+        int e = 4 * slot;
+        alive[slot] = true;
+        next[e] = e;
+        next[e + 1] = e + 3;
+        next[e + 2] = e + 2;
+        next[e + 3] = e + 1;
+        origin[e] = a;
+        origin[e + 2] = b;
+        return e;
+    }
+
+    void Splice(int a, int b)
+    {
+        int alpha = Rot(next[a]);
+        int beta = Rot(next[b]);
+        swap(next[a], next[b]);
+        swap(next[alpha], next[beta]);
+    }
+
+    // New edge from the destination of a to the origin of b, with the same left face as both
+    int Connect(EdgeSlots& slots, int a, int b)
+    {
+        int e = MakeEdge(slots, Dest(a), Org(b));
+        Splice(e, Lnext(a));
+        Splice(Sym(e), b);
+        return e;
+    }
+
+    void DeleteEdge(EdgeSlots& slots, int e)
+    {
+        Splice(e, Oprev(e));
+        Splice(Sym(e), Oprev(Sym(e)));
+        alive[e / 4] = false;
+        slots.deleted.push_back(e / 4);
+    }
+
+    bool Less(const Vector3& p, const Vector3& q, int axis)
+    {
+        // The y cut is the x cut rotated by 90 degrees clockwise, (x, y) -> (y, -x)
+        if (axis == X_AXIS) {
+            return p.x < q.x || (p.x == q.x && p.y < q.y);
+        }
+        return p.y < q.y || (p.y == q.y && p.x > q.x);
+    }
+
+    // The predicates are always evaluated on the points in the same order, so the tolerances of the kernel
+    // give the same answer for every rotation of a triangle. Returns the sign of the permutation
+    static int SortIds(int& a, int& b, int& c)
+    {
+        int sign = 1;
+        if (a > b) {
+            swap(a, b);
+            sign = -sign;
+        }
+        if (b > c) {
+            swap(b, c);
+            sign = -sign;
+        }
+        if (a > b) {
+            swap(a, b);
+            sign = -sign;
+        }
+
+        return sign;
+    }
+
+    bool CCW(int a, int b, int c)
+    {
+        int sign = SortIds(a, b, c);
+        return sign * Orient(a, b, c) > 0;
+    }
+
+    // The merge only works if the predicates agree with each other, so they go through the filter even with
+    // an inexact kernel
+    // a, b, c are sorted ids
+    int Orient(int a, int b, int c)
+    {
+        return filtered.Orient(sites[a], sites[b], sites[c]);
+    }
+
+    // a, b, c is a counterclockwise triangle
+    bool InCircle(int a, int b, int c, int d)
+    {
+        SortIds(a, b, c);
+        return filtered.InCircle(sites[a], sites[b], sites[c], sites[d]);
+    }
+
+    bool RightOf(int point, int e)
+    {
+        return CCW(point, Dest(e), Org(e));
+    }
+
+    bool LeftOf(int point, int e)
+    {
+        return CCW(point, Org(e), Dest(e));
+    }
+
+    // Orders ids[begin, end) like Build splits them: the lower half along the axis first, each half split along
+    // the other axis, down to blocks of 2 or 3 points sorted along the axis
+    void Split(int begin, int end, int axis, int parallelDepth)
+    {
+        vector<Vector3>& points = triangulation.points;
+        int n = end - begin;
+        if (n <= 3) {
+            sort(ids.begin() + begin, ids.begin() + end, [this, &points, axis](int a, int b) {
+                return Less(points[a], points[b], axis);
+            });
+            return;
+        }
+
+        int middle = (begin + end) / 2;
+        nth_element(ids.begin() + begin, ids.begin() + middle, ids.begin() + end, [this, &points, axis](int a, int b) {
+            return Less(points[a], points[b], axis);
+        });
+
+        if (parallelDepth > 0 && n > grainSize) {
+            thread left([this, begin, middle, axis, parallelDepth] {
+                Split(begin, middle, 1 - axis, parallelDepth - 1);
+            });
+            Split(middle, end, 1 - axis, parallelDepth - 1);
+            left.join();
+        } else {
+            Split(begin, middle, 1 - axis, 0);
+            Split(middle, end, 1 - axis, 0);
+        }
+    }
+
+    // Triangulates sites[begin, end), returns a hull edge having the outer face on its left
+    int Build(int begin, int end, int axis, int parallelDepth)
+    {
+        int n = end - begin;
+        if (n <= 3) {
+            return BuildSmall(begin, end);
+        }
+
+        int middle = (begin + end) / 2;
+        int leftHull, rightHull;
+        if (parallelDepth > 0 && n > grainSize) {
+            thread left([this, begin, middle, axis, parallelDepth, &leftHull] {
+                leftHull = Build(begin, middle, 1 - axis, parallelDepth - 1);
+            });
+            rightHull = Build(middle, end, 1 - axis, parallelDepth - 1);
+            left.join();
+        } else {
+            leftHull = Build(begin, middle, 1 - axis, 0);
+            rightHull = Build(middle, end, 1 - axis, 0);
+        }
+
+        return Merge(begin, axis, leftHull, rightHull);
+    }
+
+    int BuildSmall(int begin, int end)
+    {
+        EdgeSlots slots = { 3 * begin, vector<int>() };
+        int s1 = begin;
+        int s2 = begin + 1;
+        int a = MakeEdge(slots, s1, s2);
+        if (end - begin == 2) {
+            return a;
+        }
+
+        int s3 = begin + 2;
+        int b = MakeEdge(slots, s2, s3);
+        Splice(Sym(a), b);
+        if (CCW(s1, s2, s3)) {
+            Connect(slots, b, a);
+            return Sym(a);
+        }
+        if (CCW(s1, s3, s2)) {
+            int c = Connect(slots, b, a);
+            return c;
+        }
+
+        // Collinear, the outer face goes around the chain
+        return a;
+    }
+
+    // Walks the outer face of a half and finds its edges at the lowest and highest points along the axis:
+    // lowOut leaves the lowest point with the half on its left, highIn leaves the highest point with the half
+    // on its right
+    void FindExtremes(int hullEdge, int axis, int& lowOut, int& highIn)
+    {
+        int low = hullEdge;
+        int high = hullEdge;
+        int e = hullEdge;
+        do {
+            if (Less(sites[Dest(e)], sites[Dest(low)], axis)) {
+                low = e;
+            }
+            if (Less(sites[Org(high)], sites[Org(e)], axis)) {
+                high = e;
+            }
+            e = Lnext(e);
+        } while (e != hullEdge);
+
+        lowOut = Sym(low);
+        highIn = high;
+    }
+
+    int Merge(int begin, int axis, int leftHull, int rightHull)
+    {
+        int ldo, ldi, rdi, rdo;
+        FindExtremes(leftHull, axis, ldo, ldi);
+        FindExtremes(rightHull, axis, rdi, rdo);
+
+        // ldi and rdo have the outer face on their left, ldo and rdi on their right
+        // Lower common tangent of the two halves
+        while (true) {
+            if (LeftOf(Org(rdi), ldi)) {
+                ldi = Lnext(ldi);
+            } else if (RightOf(Org(ldi), rdi)) {
+                rdi = Rprev(rdi);
+            } else {
+                break;
+            }
+        }
+
+        EdgeSlots slots = { 3 * begin, vector<int>() };
+        int basel = Connect(slots, Sym(rdi), ldi);
+        if (Org(ldi) == Org(ldo)) {
+            ldo = Sym(basel);
+        }
+        if (Org(rdi) == Org(rdo)) {
+            rdo = basel;
+        }
+
+        // Zip the two halves together from the bottom up
+        while (true) {
+            int lcand = Onext(Sym(basel));
+            if (Valid(lcand, basel)) {
+                while (InCircle(Dest(basel), Org(basel), Dest(lcand), Dest(Onext(lcand)))) {
+                    int t = Onext(lcand);
+                    DeleteEdge(slots, lcand);
+                    lcand = t;
+                }
+            }
+
+            int rcand = Oprev(basel);
+            if (Valid(rcand, basel)) {
+                while (InCircle(Dest(basel), Org(basel), Dest(rcand), Dest(Oprev(rcand)))) {
+                    int t = Oprev(rcand);
+                    DeleteEdge(slots, rcand);
+                    rcand = t;
+                }
+            }
+
+            bool leftValid = Valid(lcand, basel);
+            bool rightValid = Valid(rcand, basel);
+            if (!leftValid && !rightValid) {
+                break;
+            }
+
+            if (!leftValid || (rightValid && InCircle(Dest(lcand), Org(lcand), Org(rcand), Dest(rcand)))) {
+                basel = Connect(slots, rcand, Sym(basel));
+            } else {
+                basel = Connect(slots, Sym(basel), Sym(lcand));
+            }
+        }
+
+        return Sym(ldo);
+    }
+
+    bool Valid(int e, int basel)
+    {
+        return RightOf(Dest(e), basel);
+    }
+
+    // Converts the quad edges to nodes. Every half allocates its edges the same way whatever thread builds it,
+    // so going through the slots in order gives the same nodes every time
+    void BuildNodes(int hullEdge)
+    {
+        vector<char> outer(next.size(), false);
+        int e = hullEdge;
+        do {
+            outer[e] = true;
+            e = Lnext(e);
+        } while (e != hullEdge);
+
+        // Every triangle is found from the edge leaving its lowest point id
+        vector<int> triangles;
+        for (int slot = 0; slot < alive.size(); slot++) {
+            if (!alive[slot]) {
+                continue;
+            }
+
+            for (int r = 0; r <= 2; r += 2) {
+                int e1 = 4 * slot + r;
+                int e2 = Lnext(e1);
+                int e3 = Lnext(e2);
+                if (outer[e1] || Lnext(e3) != e1 || Org(e1) > Org(e2) || Org(e1) > Org(e3)) {
+                    continue;
+                }
+
+                triangles.push_back(e1);
+            }
+        }
+
+        vector<int> faces(next.size(), -1);
+        for (int i = 0; i < triangles.size(); i++) {
+            int e1 = triangles[i];
+            faces[e1] = faces[Lnext(e1)] = faces[Lnext(Lnext(e1))] = i;
+        }
+
+        // neighbours[x] is across the edge opposite to points[x]
+        for (int i = 0; i < triangles.size(); i++) {
+            int e1 = triangles[i];
+            int e2 = Lnext(e1);
+            int e3 = Lnext(e2);
+            int nodeId = triangulation.AddNode(TriangulationNode());
+            triangulation.EditNode(nodeId, ids[Org(e1)], ids[Org(e2)], ids[Org(e3)], faces[Sym(e2)], faces[Sym(e3)], faces[Sym(e1)]);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,406 @@
+#ifndef __KERNEL__H
+#define __KERNEL__H
+
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "common.hpp"
+
+using namespace std;
+
+// Kernels hold the geometric predicates used by the triangulation engines:
+//  - Orient(p1, p2, p3) returns 1 if the points are in counterclockwise order, -1 if clockwise
+//    and 0 if they are collinear
+//  - InCircle(p1, p2, p3, point) returns true if point is strictly inside the circumcircle of the triangle
+//  - EXACT is true if the predicates are evaluated without tolerances
+//  - Quantize(point) moves the point to the closest one the kernel represents and returns false if it is out of
+//    the range of the kernel. The points are quantized once when they are read (see QuantizePoints), so the
+//    predicates don't check them
+// The engines are templates on the kernel so the predicates get inlined in the hot loops
+
+// Default kernel, same predicates (and EPS tolerances) as common.hpp
+class DoubleKernel {
+public:
+    static const bool EXACT = false;
+
+    inline bool Quantize(Vector3& point) const
+    {
+        return isfinite(point.x) && isfinite(point.y);
+    }
+
+    inline int Orient(const Vector3& p1, const Vector3& p2, const Vector3& p3) const
+    {
+        double value = det(p1, p2, p3);
+        if (value > EPS) {
+            return 1;
+        }
+
+        return value < -EPS ? -1 : 0;
+    }
+
+    inline bool InCircle(const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& point) const
+    {
+        return InsideTriangleCircumcircle(p1, p2, p3, point);
+    }
+};
+
+// Single precision kernel: the coordinates are rounded to floats and the predicates are evaluated in float, with
+// a tolerance relative to the size of the terms instead of EPS (float products of coordinates around 1000 are
+// already off by more than EPS)
+// Points within the float resolution of a line are collinear for it, so it is not a drop-in replacement of the
+// exact kernels: refining a nearly straight hull leaves flat triangles along it
+class FloatKernel {
+public:
+    static const bool EXACT = false;
+
+    // The incircle determinant is of degree 4, it overflows past 2^30
+    inline bool Quantize(Vector3& point) const
+    {
+        const double LIMIT = 1 << 30;
+        if (!(fabs(point.x) < LIMIT && fabs(point.y) < LIMIT)) {
+            return false;
+        }
+
+        point = Vector3((float)point.x, (float)point.y, point.z);
+        return true;
+    }
+
+    inline int Orient(const Vector3& p1, const Vector3& p2, const Vector3& p3) const
+    {
+        float bax = (float)p2.x - (float)p1.x, bay = (float)p2.y - (float)p1.y;
+        float cax = (float)p3.x - (float)p1.x, cay = (float)p3.y - (float)p1.y;
+        float left = bax * cay;
+        float right = bay * cax;
+        float value = left - right;
+
+        // Rounding errors of the products, and of the differences of big coordinates
+        float tolerance = 4 * FLT_EPSILON * (fabsf(left) + fabsf(right)) +
+                          FLT_EPSILON * Magnitude(p1, p2, p3) * (fabsf(bax) + fabsf(bay) + fabsf(cax) + fabsf(cay));
+        if (value > tolerance) {
+            return 1;
+        }
+
+        return value < -tolerance ? -1 : 0;
+    }
+
+    inline bool InCircle(const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& point) const
+    {
+        float adx = (float)p1.x - (float)point.x, ady = (float)p1.y - (float)point.y;
+        float bdx = (float)p2.x - (float)point.x, bdy = (float)p2.y - (float)point.y;
+        float cdx = (float)p3.x - (float)point.x, cdy = (float)p3.y - (float)point.y;
+        float aLift = adx * adx + ady * ady;
+        float bLift = bdx * bdx + bdy * bdy;
+        float cLift = cdx * cdx + cdy * cdy;
+
+        float value = aLift * (bdx * cdy - cdx * bdy) + bLift * (cdx * ady - adx * cdy) + cLift * (adx * bdy - bdx * ady);
+        float span = max(max(max(fabsf(adx), fabsf(ady)), max(fabsf(bdx), fabsf(bdy))), max(fabsf(cdx), fabsf(cdy)));
+        float tolerance = 8 * FLT_EPSILON * (aLift * (fabsf(bdx * cdy) + fabsf(cdx * bdy)) +
+                                             bLift * (fabsf(cdx * ady) + fabsf(adx * cdy)) +
+                                             cLift * (fabsf(adx * bdy) + fabsf(bdx * ady))) +
+                          24 * FLT_EPSILON * max(Magnitude(p1, p2, p3), fabsf(point.x) + fabsf(point.y)) * span * span * span;
+
+        // The sign is flipped for clockwise triangles
+        return Orient(p1, p2, p3) < 0 ? value < -tolerance : value > tolerance;
+    }
+
+private:
+    static float Magnitude(const Vector3& p1, const Vector3& p2, const Vector3& p3)
+    {
+        return max(max(fabsf(p1.x) + fabsf(p1.y), fabsf(p2.x) + fabsf(p2.y)), fabsf(p3.x) + fabsf(p3.y));
+    }
+};
+
+// Signed integer with enough bits for the incircle determinant of 64 bit coordinates
+// Stored in two's complement on 32 bit limbs, least significant limb first
+class WideInt {
+public:
+    static const int LIMBS = 9;
+    uint32_t limbs[LIMBS];
+
+    WideInt(long long value = 0)
+    {
+        uint64_t bits = (uint64_t)value;
+        limbs[0] = (uint32_t)bits;
+        limbs[1] = (uint32_t)(bits >> 32);
+        for (int i = 2; i < LIMBS; i++) {
+            limbs[i] = value < 0 ? 0xFFFFFFFFu : 0;
+        }
+    }
+
+    int Sign() const
+    {
+        if (limbs[LIMBS - 1] & 0x80000000u) {
+            return -1;
+        }
+
+        for (int i = 0; i < LIMBS; i++) {
+            if (limbs[i] != 0) {
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+};
+
+inline WideInt operator+(const WideInt& lhs, const WideInt& rhs)
+{
+    WideInt result;
+    uint64_t carry = 0;
+    for (int i = 0; i < WideInt::LIMBS; i++) {
+        uint64_t sum = (uint64_t)lhs.limbs[i] + rhs.limbs[i] + carry;
+        result.limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+
+    return result;
+}
+
+inline WideInt operator-(const WideInt& lhs, const WideInt& rhs)
+{
+    // lhs + ~rhs + 1
+    WideInt result;
+    uint64_t carry = 1;
+    for (int i = 0; i < WideInt::LIMBS; i++) {
+        uint64_t sum = (uint64_t)lhs.limbs[i] + (uint32_t)~rhs.limbs[i] + carry;
+        result.limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+
+    return result;
+}
+
+// Product modulo 2^(32 * LIMBS), which is the exact result as long as it fits
+inline WideInt operator*(const WideInt& lhs, const WideInt& rhs)
+{
+    WideInt result;
+    for (int i = 0; i < WideInt::LIMBS; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; i + j < WideInt::LIMBS; j++) {
+            uint64_t cell = (uint64_t)lhs.limbs[i] * rhs.limbs[j] + result.limbs[i + j] + carry;
+            result.limbs[i + j] = (uint32_t)cell;
+            carry = cell >> 32;
+        }
+    }
+
+    return result;
+}
+
+// Exact kernel for fixed point data: every coordinate is rounded to an integer multiple of 1 / scale
+// (ex. scale = 100 for the %.2f inputs from generate_test.py) and the predicates are evaluated with
+// integer arithmetic, so there are no tolerances involved
+template <typename T>
+class FixedKernel;
+
+// Rounds value * scale to the closest integer (halfway cases away from 0), without the call to llround
+// Quantized coordinates are within rounding errors of an integer once scaled, so this is cheap and exact
+inline long long RoundScaled(double value, double scale)
+{
+    double scaled = value * scale;
+    long long fixed = (long long)scaled;
+    double rest = scaled - fixed;
+    return fixed + (rest >= 0.5) - (rest <= -0.5);
+}
+
+// Snaps the point to the grid of multiples of 1 / scale, returns false if |coordinate * scale| isn't below limit
+inline bool QuantizeFixed(Vector3& point, double scale, double limit)
+{
+    if (!(fabs(point.x * scale) < limit && fabs(point.y * scale) < limit)) {
+        return false;
+    }
+
+    point = Vector3(RoundScaled(point.x, scale) / scale, RoundScaled(point.y, scale) / scale, point.z);
+    return true;
+}
+
+// 32 bit coordinates, exact with 128 bit arithmetic as long as |coordinate * scale| < 2^29
+template <>
+class FixedKernel<int32_t> {
+public:
+    static const bool EXACT = true;
+
+    double scale;
+
+    FixedKernel(double _scale = 100) : scale(_scale) {};
+
+    inline bool Quantize(Vector3& point) const
+    {
+        return QuantizeFixed(point, scale, 1 << 29);
+    }
+
+    inline long long Fixed(double value) const
+    {
+        return RoundScaled(value, scale);
+    }
+
+    inline int Orient(const Vector3& p1, const Vector3& p2, const Vector3& p3) const
+    {
+        long long x1 = Fixed(p1.x), y1 = Fixed(p1.y);
+        long long value = (Fixed(p2.x) - x1) * (Fixed(p3.y) - y1) - (Fixed(p2.y) - y1) * (Fixed(p3.x) - x1);
+
+        return (value > 0) - (value < 0);
+    }
+
+    inline bool InCircle(const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& point) const
+    {
+        long long x = Fixed(point.x), y = Fixed(point.y);
+        long long adx = Fixed(p1.x) - x, ady = Fixed(p1.y) - y;
+        long long bdx = Fixed(p2.x) - x, bdy = Fixed(p2.y) - y;
+        long long cdx = Fixed(p3.x) - x, cdy = Fixed(p3.y) - y;
+
+        __int128 value = (__int128)(adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) +
+                         (__int128)(bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy) +
+                         (__int128)(cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+
+        return Orient(p1, p2, p3) < 0 ? value < 0 : value > 0;
+    }
+};
+
+// 64 bit coordinates, exact as long as |coordinate * scale| < 2^62
+// Note coordinates are stored as doubles, so only values up to 2^53 are represented exactly
+template <>
+class FixedKernel<int64_t> {
+public:
+    static const bool EXACT = true;
+
+    double scale;
+
+    FixedKernel(double _scale = 100) : scale(_scale) {};
+
+    inline bool Quantize(Vector3& point) const
+    {
+        return QuantizeFixed(point, scale, 4611686018427387904.0);
+    }
+
+    inline long long Fixed(double value) const
+    {
+        return RoundScaled(value, scale);
+    }
+
+    inline int Orient(const Vector3& p1, const Vector3& p2, const Vector3& p3) const
+    {
+        long long x1 = Fixed(p1.x), y1 = Fixed(p1.y);
+        __int128 value = (__int128)(Fixed(p2.x) - x1) * (Fixed(p3.y) - y1) -
+                         (__int128)(Fixed(p2.y) - y1) * (Fixed(p3.x) - x1);
+
+        return (value > 0) - (value < 0);
+    }
+
+    inline bool InCircle(const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& point) const
+    {
+        long long x = Fixed(point.x), y = Fixed(point.y);
+        WideInt adx = Fixed(p1.x) - x, ady = Fixed(p1.y) - y;
+        WideInt bdx = Fixed(p2.x) - x, bdy = Fixed(p2.y) - y;
+        WideInt cdx = Fixed(p3.x) - x, cdy = Fixed(p3.y) - y;
+
+        WideInt value = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) +
+                        (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy) +
+                        (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+
+        return Orient(p1, p2, p3) < 0 ? value.Sign() < 0 : value.Sign() > 0;
+    }
+};
+
+typedef FixedKernel<int32_t> Fixed32Kernel;
+typedef FixedKernel<int64_t> Fixed64Kernel;
+
+// Floating point filter in front of a kernel. The tolerances of an inexact kernel are too coarse for the
+// engines that need their predicates to agree with each other (ex. the double kernel never finds a point
+// inside the circle of a triangle smaller than 0.1, and calls three points on a big circle collinear)
+// The determinants are evaluated with plain doubles first, and the kernel only decides when they are within
+// rounding errors of 0 (error bounds from Shewchuk's adaptive predicates, plus the error of storing decimal
+// coordinates as doubles, so points that are collinear or cocircular in the input stay so)
+// Exact kernels decide everything, they might not see the raw coordinates
+template <typename Kernel>
+class FilteredKernel {
+public:
+    static const bool EXACT = Kernel::EXACT;
+
+    Kernel kernel;
+
+    FilteredKernel(Kernel _kernel = Kernel()) : kernel(_kernel) {};
+
+    inline bool Quantize(Vector3& point) const
+    {
+        return kernel.Quantize(point);
+    }
+
+    inline int Orient(const Vector3& p1, const Vector3& p2, const Vector3& p3) const
+    {
+        if (EXACT) {
+            return kernel.Orient(p1, p2, p3);
+        }
+
+        double bax = p2.x - p1.x, bay = p2.y - p1.y;
+        double cax = p3.x - p1.x, cay = p3.y - p1.y;
+        double left = bax * cay;
+        double right = bay * cax;
+        double value = left - right;
+        double bound = 3.3307e-16 * (fabs(left) + fabs(right)) +
+                       2.3e-16 * Magnitude(p1, p2, p3) * (fabs(bax) + fabs(bay) + fabs(cax) + fabs(cay));
+        if (fabs(value) <= bound) {
+            return kernel.Orient(p1, p2, p3);
+        }
+
+        return value > 0 ? 1 : -1;
+    }
+
+    inline bool InCircle(const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& point) const
+    {
+        if (EXACT) {
+            return kernel.InCircle(p1, p2, p3, point);
+        }
+
+        double adx = p1.x - point.x, ady = p1.y - point.y;
+        double bdx = p2.x - point.x, bdy = p2.y - point.y;
+        double cdx = p3.x - point.x, cdy = p3.y - point.y;
+        double aLift = adx * adx + ady * ady;
+        double bLift = bdx * bdx + bdy * bdy;
+        double cLift = cdx * cdx + cdy * cdy;
+
+        double value = aLift * (bdx * cdy - cdx * bdy) + bLift * (cdx * ady - adx * cdy) + cLift * (adx * bdy - bdx * ady);
+        double span = max(max(max(fabs(adx), fabs(ady)), max(fabs(bdx), fabs(bdy))), max(fabs(cdx), fabs(cdy)));
+        double bound = 1.1102e-15 * (aLift * (fabs(bdx * cdy) + fabs(cdx * bdy)) + bLift * (fabs(cdx * ady) + fabs(adx * cdy)) +
+                                     cLift * (fabs(adx * bdy) + fabs(bdx * ady))) +
+                       1.1e-14 * max(Magnitude(p1, p2, p3), fabs(point.x) + fabs(point.y)) * span * span * span;
+        if (fabs(value) <= bound) {
+            return kernel.InCircle(p1, p2, p3, point);
+        }
+
+        // The sign is flipped for clockwise triangles
+        return Orient(p1, p2, p3) < 0 ? value < 0 : value > 0;
+    }
+
+private:
+    // Bounds the absolute values of the coordinates of three points
+    static double Magnitude(const Vector3& p1, const Vector3& p2, const Vector3& p3)
+    {
+        return max(max(fabs(p1.x) + fabs(p1.y), fabs(p2.x) + fabs(p2.y)), fabs(p3.x) + fabs(p3.y));
+    }
+};
+
+// Quantizes the points read from the input for the kernel
+// Returns false if one of them is out of the range of the kernel
+template <typename Kernel>
+bool QuantizePoints(vector<Vector3>& points, const Kernel& kernel)
+{
+    for (int i = 0; i < points.size(); i++) {
+        if (!kernel.Quantize(points[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Kernel used by the binaries, picked at compile time (ex. make KERNEL=Fixed32Kernel)
+#ifndef KERNEL
+#define KERNEL DoubleKernel
+#endif
+
+typedef KERNEL DefaultKernel;
+
+#endif
@@ -0,0 +1,334 @@
+#ifndef __KINETIC__H
+#define __KINETIC__H
+
+#include <vector>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "constrained.hpp"
+#include "kernel.hpp"
+
+using namespace std;
+
+// Moves points of a (counterclockwise, delaunay) triangulation and keeps it delaunay
+// Small moves keep every triangle around the point counterclockwise, so only the coordinates change and
+// the edges around the point are flipped back to delaunay. Bigger moves remove the point from its star
+// and insert it again at the new position. Both only touch the triangles around the two positions
+// Constrained edges are never flipped, the ones ending at a moved point move with it
+// Note points on the convex hull can't be moved, keep a frame of fixed points (or the super triangle)
+// around the moving ones
+template <typename Kernel = DefaultKernel>
+class KineticTriangulation {
+public:
+    Triangulation& triangulation;
+    ConstrainedDelaunay<Kernel> constrained;
+
+    KineticTriangulation(Triangulation& _triangulation, Kernel _kernel = Kernel()) :
+        triangulation(_triangulation), constrained(_triangulation, _kernel)
+    {
+        pointNodes.assign(triangulation.points.size(), -1);
+        for (int i = 0; i < triangulation.nodes.size(); i++) {
+            for (int x = 0; x < 3; x++) {
+                pointNodes[triangulation.nodes[i].points[x]] = i;
+            }
+        }
+    };
+
+    // Moves the point to the new position. Returns false if the point can't be moved (it is on the hull,
+    // the new position is outside the triangulation, on top of another point or out of the range of the
+    // kernel), or if a constrained edge ending at the point crosses another constrained edge after the move
+    // and had to be dropped
+    bool MovePoint(int pointId, Vector3 position)
+    {
+        if (!constrained.kernel.Quantize(position) || !FindStar(pointId)) {
+            return false;
+        }
+
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        Kernel& kernel = constrained.kernel;
+        triangulation.InvalidateConvexHull();
+
+        bool starValid = true;
+        for (int i = 0; i < star.size() && starValid; i++) {
+            starValid = kernel.Orient(position, points[link[i]], points[link[(i + 1) % link.size()]]) > 0;
+        }
+
+        if (starValid) {
+            points[pointId] = position;
+            for (int i = 0; i < star.size(); i++) {
+                for (int x = 0; x < 3; x++) {
+                    constrained.flipQueue.push_back(make_pair(star[i], x));
+                }
+            }
+            constrained.LegalizeEdges();
+            constrained.lastNode = pointNodes[pointId] = star[0];
+            return true;
+        }
+
+        // The new position has to be inside the triangulation and not on top of another point
+        int nodeId = triangulation.JumpAndWalk(position, star[0], kernel);
+        if (nodeId == -1) {
+            return false;
+        }
+        for (int x = 0; x < 3; x++) {
+            int other = nodes[nodeId].points[x];
+            if (other != pointId && GetDistance(points[other], position) < EPS) {
+                return false;
+            }
+
+            // Landing on the hull would leave the point with an open star
+            int q = nodes[nodeId].points[(x + 1) % 3];
+            int r = nodes[nodeId].points[(x + 2) % 3];
+            if (nodes[nodeId].neighbours[x] == -1 && kernel.Orient(points[q], points[r], position) == 0) {
+                return false;
+            }
+        }
+
+        if (!TriangulateLink()) {
+            return false;
+        }
+
+        // The constrained edges of the point are inserted again once it is in its new place
+        vector<int> constrainedLink;
+        for (int i = 0; i < link.size(); i++) {
+            if (triangulation.IsConstrained(pointId, link[i])) {
+                constrainedLink.push_back(link[i]);
+                triangulation.SetConstrained(pointId, link[i], false);
+            }
+        }
+
+        RemoveFromStar();
+        points[pointId] = position;
+        InsertPoint(pointId);
+        pointNodes[pointId] = star[0];
+
+        bool keptConstraints = true;
+        for (int i = 0; i < constrainedLink.size(); i++) {
+            keptConstraints &= constrained.InsertConstraint(pointId, constrainedLink[i]);
+        }
+
+        return keptConstraints;
+    }
+
+    // Moves a batch of points (ex. the ones that moved in a frame). Close points are moved one after the
+    // other so the walks stay short. Returns how many points couldn't be moved
+    int MovePoints(const vector<int>& pointIds, const vector<Vector3>& positions)
+    {
+        vector<int> order;
+        for (int i = 0; i < pointIds.size(); i++) {
+            order.push_back(i);
+        }
+
+        vector<Vector3> oldPositions;
+        for (int i = 0; i < pointIds.size(); i++) {
+            oldPositions.push_back(triangulation.points[pointIds[i]]);
+        }
+        SpatialSort(oldPositions, order);
+
+        int failed = 0;
+        for (int i = 0; i < order.size(); i++) {
+            if (!MovePoint(pointIds[order[i]], positions[order[i]])) {
+                failed++;
+            }
+        }
+
+        return failed;
+    }
+
+private:
+    // Triangles around the current point in counterclockwise order, link[i] is the point
+    // after the current one in star[i]
+    vector<int> star;
+    vector<int> link;
+
+    vector<int> polygon;
+    vector<int> newTriangles;
+
+    // A node around every point, as of the last time the point was moved. Flips around the point can
+    // take it away, then it is still a good place to start the walk from
+    vector<int> pointNodes;
+
+    // Fills star and link for the point, returns false if the point is on the hull (or not in the triangulation)
+    bool FindStar(int pointId)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        star.clear();
+        link.clear();
+
+        int startNode = -1;
+        if (pointId < pointNodes.size() && pointNodes[pointId] != -1 && pointNodes[pointId] < nodes.size()) {
+            if (ConstrainedDelaunay<Kernel>::LocalIndex(nodes[pointNodes[pointId]], pointId) != -1) {
+                startNode = pointNodes[pointId];
+            } else {
+                constrained.lastNode = pointNodes[pointId];
+            }
+        } else {
+            pointNodes.resize(triangulation.points.size(), -1);
+        }
+
+        if (startNode == -1) {
+            startNode = constrained.FindPointNode(pointId);
+        }
+        if (startNode == -1) {
+            return false;
+        }
+
+        int nodeId = startNode;
+        do {
+            int k = ConstrainedDelaunay<Kernel>::LocalIndex(nodes[nodeId], pointId);
+            star.push_back(nodeId);
+            link.push_back(nodes[nodeId].points[(k + 1) % 3]);
+            nodeId = nodes[nodeId].neighbours[(k + 1) % 3];
+        } while (nodeId != -1 && nodeId != startNode);
+
+        return nodeId == startNode;
+    }
+
+    // Triangulates the link of the current point into newTriangles, the ears with an empty circumcircle first
+    // Around constrained edges there might be none of those, any ear does then
+    // Returns false if there is no ear left because of (almost) flat corners
+    bool TriangulateLink()
+    {
+        polygon = link;
+        newTriangles.clear();
+        while (polygon.size() > 3) {
+            int ear = -1;
+            for (int i = 0; i < polygon.size() && ear == -1; i++) {
+                if (IsEar(i, true)) {
+                    ear = i;
+                }
+            }
+            for (int i = 0; i < polygon.size() && ear == -1; i++) {
+                if (IsEar(i, false)) {
+                    ear = i;
+                }
+            }
+
+            if (ear == -1) {
+                return false;
+            }
+
+            newTriangles.push_back(polygon[(ear + polygon.size() - 1) % polygon.size()]);
+            newTriangles.push_back(polygon[ear]);
+            newTriangles.push_back(polygon[(ear + 1) % polygon.size()]);
+            polygon.erase(polygon.begin() + ear);
+        }
+
+        newTriangles.insert(newTriangles.end(), polygon.begin(), polygon.end());
+        return true;
+    }
+
+    // Replaces the star of the current point with the triangulation of its link, leaving the point out of the
+    // triangulation. Two nodes are left over, they are reused when the point is inserted again
+    void RemoveFromStar()
+    {
+        constrained.ReplaceNodes(star, newTriangles);
+
+        // The new triangles took the first ids of the star
+        for (int i = 0; i < newTriangles.size() / 3; i++) {
+            for (int x = 0; x < 3; x++) {
+                constrained.flipQueue.push_back(make_pair(star[i], x));
+            }
+        }
+        constrained.LegalizeEdges();
+    }
+
+    // True if the corner i of the polygon can be cut off: it is convex and no other point of the polygon is
+    // inside the triangle (or its circumcircle if delaunay is set)
+    bool IsEar(int i, bool delaunay)
+    {
+        vector<Vector3>& points = triangulation.points;
+        Kernel& kernel = constrained.kernel;
+        int a = polygon[(i + polygon.size() - 1) % polygon.size()];
+        int b = polygon[i];
+        int c = polygon[(i + 1) % polygon.size()];
+        if (kernel.Orient(points[a], points[b], points[c]) <= 0) {
+            return false;
+        }
+
+        for (int j = 0; j < polygon.size(); j++) {
+            int d = polygon[j];
+            if (d == a || d == b || d == c) {
+                continue;
+            }
+
+            if (delaunay && kernel.InCircle(points[a], points[b], points[c], points[d])) {
+                return false;
+            }
+            if (kernel.Orient(points[a], points[b], points[d]) >= 0 && kernel.Orient(points[b], points[c], points[d]) >= 0 &&
+                kernel.Orient(points[c], points[a], points[d]) >= 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Inserts the point (not used by any triangle) into the triangle containing it, which isn't on the hull
+    void InsertPoint(int pointId)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        Kernel& kernel = constrained.kernel;
+        Vector3 position = points[pointId];
+
+        int nodeId = triangulation.JumpAndWalk(position, constrained.lastNode, kernel);
+
+        // The region replaced by the fan around the point, given by its border in counterclockwise order
+        vector<int> region(1, nodeId);
+        polygon.assign(nodes[nodeId].points, nodes[nodeId].points + 3);
+
+        // A point on an edge replaces the triangles on both sides of it
+        int splitEdge = -1;
+        for (int x = 0; x < 3; x++) {
+            int q = nodes[nodeId].points[(x + 1) % 3];
+            int r = nodes[nodeId].points[(x + 2) % 3];
+            if (kernel.Orient(points[q], points[r], position) == 0 && nodes[nodeId].neighbours[x] != -1) {
+                splitEdge = x;
+                int neighbour = nodes[nodeId].neighbours[x];
+                region.push_back(neighbour);
+                polygon.clear();
+                polygon.push_back(nodes[nodeId].points[x]);
+                polygon.push_back(q);
+                polygon.push_back(nodes[neighbour].points[
+                    (ConstrainedDelaunay<Kernel>::LocalIndex(nodes[neighbour], q) + 1) % 3]);
+                polygon.push_back(r);
+                break;
+            }
+        }
+
+        // Constrained edges the point is on are split in two
+        if (splitEdge != -1) {
+            int q = nodes[nodeId].points[(splitEdge + 1) % 3];
+            int r = nodes[nodeId].points[(splitEdge + 2) % 3];
+            if (triangulation.IsConstrained(q, r)) {
+                triangulation.SetConstrained(q, r, false);
+                triangulation.SetConstrained(q, pointId, true);
+                triangulation.SetConstrained(pointId, r, true);
+            }
+        }
+
+        // Fan around the point
+        newTriangles.clear();
+        for (int i = 0; i < polygon.size(); i++) {
+            int p1 = polygon[i];
+            int p2 = polygon[(i + 1) % polygon.size()];
+            newTriangles.push_back(pointId);
+            newTriangles.push_back(p1);
+            newTriangles.push_back(p2);
+        }
+
+        constrained.ReplaceNodes(region, newTriangles);
+
+        // The edges of the old region, now opposite to the point, might not be delaunay anymore
+        FindStar(pointId);
+        for (int i = 0; i < star.size(); i++) {
+            int x = ConstrainedDelaunay<Kernel>::LocalIndex(nodes[star[i]], pointId);
+            constrained.flipQueue.push_back(make_pair(star[i], x));
+        }
+        constrained.LegalizeEdges();
+    }
+};
+
+#endif
@@ -0,0 +1,499 @@
+#ifndef __NAVMESH__H
+#define __NAVMESH__H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include "nodegrid.hpp"
+
+using namespace std;
+
+// Shortest paths over a triangulation used as a navmesh. Constrained edges (and the hull) are walls, paths never
+// cross them
+// The search is an A* over intervals of edges seen from a root (Polyanya, Cui et al.): every search node is the
+// part of an edge visible from its root through the previous intervals, the root is the start or the last corner
+// the path turns around. Its cost is the length of the path to the root, plus the shortest way from the root
+// to the goal through the interval, so the first path found is the shortest one. A root is only expanded again
+// from a cheaper path, and paths only turn around corners (points where the walls leave more than half a turn
+// free, like the end of a wall)
+// Every thread keeps its own search state, sized for all the points and stamped with the number of the search
+// instead of being cleared, so a search only touches the roots it reaches. Call Update after editing the nodes
+template <typename Kernel = DefaultKernel>
+class NavmeshPathfinder {
+public:
+    Triangulation& triangulation;
+    Kernel kernel;
+
+    NavmeshPathfinder(Triangulation& _triangulation, Kernel _kernel = Kernel()) :
+        triangulation(_triangulation), kernel(_kernel), states(ThreadsCount())
+    {
+        Update();
+    };
+
+    // Finds the start nodes of the walks and the corners again, and makes room for the search state of new points
+    void Update()
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        grid.Build(triangulation);
+
+        vector<int> pointNode(triangulation.points.size(), -1);
+        for (int i = 0; i < nodes.size(); i++) {
+            for (int x = 0; x < 3; x++) {
+                pointNode[nodes[i].points[x]] = i;
+            }
+        }
+
+        corners.assign(triangulation.points.size(), 0);
+        for (int i = 0; i < pointNode.size(); i++) {
+            corners[i] = pointNode[i] != -1 && IsCorner(i, pointNode[i]);
+        }
+
+        for (int t = 0; t < states.size(); t++) {
+            states[t].Resize(triangulation.points.size());
+        }
+    }
+
+    // Replaces path with the corners of the path from start to goal (both included). Returns false if one of them
+    // is outside the triangulation (or the range of the kernel) or the walls separate them
+    bool FindPath(const Vector3& start, const Vector3& goal, vector<Vector3>& path)
+    {
+        return FindPath(start, goal, path, states[0]);
+    }
+
+    // Finds the paths between starts[i] and goals[i] on all the threads, paths[i] is left empty if there is none
+    // Returns how many paths couldn't be found
+    int FindPaths(const vector<Vector3>& starts, const vector<Vector3>& goals, vector<vector<Vector3>>& paths)
+    {
+        paths.resize(starts.size());
+        vector<int> failed(states.size(), 0);
+        ParallelFor(starts.size(), [&](int t, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                if (!FindPath(starts[i], goals[i], paths[i], states[t])) {
+                    paths[i].clear();
+                    failed[t]++;
+                }
+            }
+        });
+
+        int failedCnt = 0;
+        for (int t = 0; t < failed.size(); t++) {
+            failedCnt += failed[t];
+        }
+        return failedCnt;
+    }
+
+private:
+    // Interval left-right of the edge of the node opposite to points[edge], seen from the root. left and right
+    // are the ends of the interval as seen from the root, leftId and rightId are the points they are (or -1)
+    // A final search node has reached the goal, with nothing left to expand
+    struct SearchNode {
+        double cost;
+        double length;
+        int root;
+        int nodeId;
+        int edge;
+        Vector3 left;
+        Vector3 right;
+        int leftId;
+        int rightId;
+        bool final;
+
+        bool operator>(const SearchNode& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    // Point the path turns at, and the index of the previous one
+    struct Root {
+        Vector3 point;
+        int parent;
+    };
+
+    struct SearchState {
+        // A point was a root in this search, with the length of the path to it, if its mark is the current epoch
+        vector<unsigned int> marks;
+        vector<double> lengths;
+        unsigned int epoch;
+
+        // Binary heap of the search nodes to expand
+        vector<SearchNode> open;
+        vector<Root> roots;
+
+        SearchState() : epoch(0) {};
+
+        void Resize(int pointsCnt)
+        {
+            marks.resize(pointsCnt, 0);
+            lengths.resize(pointsCnt);
+        }
+    };
+
+    vector<SearchState> states;
+    NodeGrid grid;
+
+    // Points where the walls leave more than half a turn free on one side, the only places where a shortest path
+    // turns (ex. the end of a wall, but not the points along a straight wall or the hull)
+    vector<char> corners;
+
+    int Locate(const Vector3& point)
+    {
+        int start = grid.Find(point);
+        return triangulation.JumpAndWalk(point, start != -1 ? start : 0, kernel);
+    }
+
+    // Goes around the point from the node, starting after a wall, and adds up the angles of the nodes between
+    // two walls
+    bool IsCorner(int pointId, int nodeId)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+
+        // Clockwise up to a wall, a point without walls around it is never a corner
+        int firstNode = nodeId;
+        for (int steps = 0; steps < nodes.size(); steps++) {
+            int x = LocalIndex(nodes[firstNode], pointId);
+            if (!IsPassable(firstNode, (x + 2) % 3)) {
+                break;
+            }
+
+            firstNode = nodes[firstNode].neighbours[(x + 2) % 3];
+            if (firstNode == nodeId) {
+                return false;
+            }
+        }
+
+        // Then counterclockwise, the free angle starts over after every wall
+        double angle = 0;
+        nodeId = firstNode;
+        for (int steps = 0; steps < nodes.size(); steps++) {
+            TriangulationNode& node = nodes[nodeId];
+            int x = LocalIndex(node, pointId);
+            Vector3 u = points[node.points[(x + 1) % 3]] - points[pointId];
+            Vector3 v = points[node.points[(x + 2) % 3]] - points[pointId];
+            angle += atan2(fabs(u.x * v.y - u.y * v.x), u.x * v.x + u.y * v.y);
+            if (angle > M_PI + EPS) {
+                return true;
+            }
+
+            if (!IsPassable(nodeId, (x + 1) % 3)) {
+                angle = 0;
+            }
+            nodeId = node.neighbours[(x + 1) % 3];
+            if (nodeId == -1 || nodeId == firstNode) {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    // The edge opposite to points[x] can be crossed
+    bool IsPassable(int nodeId, int x)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        return node.neighbours[x] != -1 &&
+               !triangulation.IsConstrained(node.points[(x + 1) % 3], node.points[(x + 2) % 3]);
+    }
+
+    bool FindPath(Vector3 start, Vector3 goal, vector<Vector3>& path, SearchState& state)
+    {
+        path.clear();
+        if (triangulation.nodes.empty() || !kernel.Quantize(start) || !kernel.Quantize(goal)) {
+            return false;
+        }
+
+        int startNode = Locate(start);
+        int goalNode = Locate(goal);
+        if (startNode == -1 || goalNode == -1) {
+            return false;
+        }
+
+        // The roots are only cleared when the epoch wraps around
+        if (++state.epoch == 0) {
+            fill(state.marks.begin(), state.marks.end(), 0);
+            state.epoch = 1;
+        }
+
+        state.open.clear();
+        state.roots.clear();
+        Root first = { start, -1 };
+        state.roots.push_back(first);
+
+        // Everything in the start node is seen from the start
+        if (startNode == goalNode) {
+            PushFinal(0, 0, goal, state);
+        }
+        for (int x = 0; x < 3; x++) {
+            PushEdge(0, 0, startNode, x, state, goal);
+        }
+
+        while (!state.open.empty()) {
+            pop_heap(state.open.begin(), state.open.end(), greater<SearchNode>());
+            SearchNode node = state.open.back();
+            state.open.pop_back();
+
+            if (node.final) {
+                for (int root = node.root; root != -1; root = state.roots[root].parent) {
+                    path.push_back(state.roots[root].point);
+                }
+                reverse(path.begin(), path.end());
+                if (!Same(path.back(), goal)) {
+                    path.push_back(goal);
+                }
+                return true;
+            }
+
+            Expand(node, goalNode, goal, state);
+        }
+
+        return false;
+    }
+
+    // Pushes the intervals of the node seen from the root through the search node, and the ones seen from its
+    // ends if the path can turn there
+    void Expand(const SearchNode& node, int goalNode, const Vector3& goal, SearchState& state)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        TriangulationNode& crt = nodes[node.nodeId];
+        int x = node.edge;
+        int a = crt.points[(x + 1) % 3];
+        int b = crt.points[(x + 2) % 3];
+        int c = crt.points[x];
+        Vector3 root = state.roots[node.root].point;
+
+        // The far side of the node is a -> c -> b, positions 0 to 2 along it, seen from left to right
+        double leftEnd = 0;
+        double rightEnd = 2;
+        if (Turn(points[a], points[b], root) != 0) {
+            leftEnd = FarPosition(root, node.left, points[a], points[b], points[c]);
+            rightEnd = max(leftEnd, FarPosition(root, node.right, points[a], points[b], points[c]));
+        }
+
+        if (node.nodeId == goalNode && Turn(root, node.left, goal) <= 0 && Turn(root, node.right, goal) >= 0) {
+            PushFinal(node.root, node.length, goal, state);
+        }
+
+        if (leftEnd < 1 && min(rightEnd, 1.0) > leftEnd) {
+            PushInterval(node.root, node.length, node.nodeId, (x + 2) % 3, FarPoint(leftEnd, a, b, c),
+                         leftEnd == 0 ? a : -1, FarPoint(min(rightEnd, 1.0), a, b, c), rightEnd >= 1 ? c : -1,
+                         state, goal);
+        }
+        if (rightEnd > 1 && rightEnd > max(leftEnd, 1.0)) {
+            PushInterval(node.root, node.length, node.nodeId, (x + 1) % 3, FarPoint(max(leftEnd, 1.0), a, b, c),
+                         leftEnd <= 1 ? c : -1, FarPoint(rightEnd, a, b, c), rightEnd == 2 ? b : -1, state, goal);
+        }
+
+        // Behind a corner at the left end the path turns around it: the rest of the far side, then the nodes
+        // around the corner up to the wall
+        if (node.leftId == a && corners[a]) {
+            int turn = AddRoot(node.root, node.length, a, state);
+            if (turn != -1) {
+                double length = state.lengths[a];
+                if (node.nodeId == goalNode) {
+                    PushFinal(turn, length, goal, state);
+                }
+                if (leftEnd > 1) {
+                    PushInterval(turn, length, node.nodeId, (x + 1) % 3, points[c], c, FarPoint(leftEnd, a, b, c),
+                                 leftEnd == 2 ? b : -1, state, goal);
+                }
+                Sweep(turn, length, a, node.nodeId, c, goalNode, goal, state);
+            }
+        }
+
+        if (node.rightId == b && corners[b]) {
+            int turn = AddRoot(node.root, node.length, b, state);
+            if (turn != -1) {
+                double length = state.lengths[b];
+                if (node.nodeId == goalNode) {
+                    PushFinal(turn, length, goal, state);
+                }
+                if (rightEnd < 1) {
+                    PushInterval(turn, length, node.nodeId, (x + 2) % 3, FarPoint(rightEnd, a, b, c),
+                                 rightEnd == 0 ? a : -1, points[c], c, state, goal);
+                }
+                Sweep(turn, length, b, node.nodeId, c, goalNode, goal, state);
+            }
+        }
+    }
+
+    // Makes pointId the next root after parent, unless it was reached by a path at most as long
+    // Returns the index of the new root or -1
+    int AddRoot(int parent, double length, int pointId, SearchState& state)
+    {
+        Vector3& point = triangulation.points[pointId];
+        length += GetDistance(state.roots[parent].point, point);
+        if (state.marks[pointId] == state.epoch && state.lengths[pointId] < length) {
+            return -1;
+        }
+
+        state.marks[pointId] = state.epoch;
+        state.lengths[pointId] = length;
+        Root root = { point, parent };
+        state.roots.push_back(root);
+        return state.roots.size() - 1;
+    }
+
+    // Goes around the corner pointId from the node, across its edge to other, until a wall. The edges opposite
+    // to the corner are seen whole from it
+    void Sweep(int root, double length, int pointId, int nodeId, int other, int goalNode, const Vector3& goal,
+               SearchState& state)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        int firstNode = nodeId;
+        for (int steps = 0; steps < nodes.size(); steps++) {
+            int x = 3 - LocalIndex(nodes[nodeId], pointId) - LocalIndex(nodes[nodeId], other);
+            if (!IsPassable(nodeId, x)) {
+                return;
+            }
+
+            int nextNode = nodes[nodeId].neighbours[x];
+            if (nextNode == firstNode) {
+                return;
+            }
+
+            TriangulationNode& next = nodes[nextNode];
+            int corner = LocalIndex(next, pointId);
+            if (nextNode == goalNode) {
+                PushFinal(root, length, goal, state);
+            }
+            PushEdge(root, length, nextNode, corner, state, goal);
+
+            // The third point of the next node is the other end of the next edge around the corner
+            other = next.points[(corner + 1) % 3] == other ? next.points[(corner + 2) % 3] :
+                                                               next.points[(corner + 1) % 3];
+            nodeId = nextNode;
+        }
+    }
+
+    // Pushes the whole edge of the node opposite to points[x]
+    void PushEdge(int root, double length, int nodeId, int x, SearchState& state, const Vector3& goal)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        int p1 = node.points[(x + 1) % 3];
+        int p2 = node.points[(x + 2) % 3];
+        PushInterval(root, length, nodeId, x, triangulation.points[p2], p2, triangulation.points[p1], p1, state, goal);
+    }
+
+    // Pushes the interval of the edge of the node opposite to points[x], as seen from inside the node, to be
+    // expanded in the node across it
+    void PushInterval(int root, double length, int nodeId, int x, const Vector3& left, int leftId,
+                      const Vector3& right, int rightId, SearchState& state, const Vector3& goal)
+    {
+        if (!IsPassable(nodeId, x)) {
+            return;
+        }
+
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        int neighbour = node.neighbours[x];
+        TriangulationNode& other = triangulation.nodes[neighbour];
+        int edge = 0;
+        while (other.points[edge] == node.points[(x + 1) % 3] || other.points[edge] == node.points[(x + 2) % 3]) {
+            edge++;
+        }
+
+        SearchNode next = { length + Estimate(state.roots[root].point, left, right, goal), length, root, neighbour,
+                            edge, left, right, leftId, rightId, false };
+        state.open.push_back(next);
+        push_heap(state.open.begin(), state.open.end(), greater<SearchNode>());
+    }
+
+    void PushFinal(int root, double length, const Vector3& goal, SearchState& state)
+    {
+        SearchNode next = { length + GetDistance(state.roots[root].point, goal), length, root, -1, -1, goal, goal,
+                            -1, -1, true };
+        state.open.push_back(next);
+        push_heap(state.open.begin(), state.open.end(), greater<SearchNode>());
+    }
+
+    // Length of the shortest way from the root to the goal through the interval left-right, ignoring the walls
+    // A goal on the side of the root is mirrored to the other side first
+    static double Estimate(const Vector3& root, const Vector3& left, const Vector3& right, Vector3 goal)
+    {
+        double rootSide = Turn(left, right, root);
+        double goalSide = Turn(left, right, goal);
+        if (rootSide == 0) {
+            return GetDistance(root, goal);
+        }
+        if ((rootSide > 0) == (goalSide > 0)) {
+            double dx = right.x - left.x;
+            double dy = right.y - left.y;
+            double t = ((goal.x - left.x) * dx + (goal.y - left.y) * dy) / (dx * dx + dy * dy);
+            Vector3 foot(left.x + t * dx, left.y + t * dy, 0);
+            goal = Vector3(2 * foot.x - goal.x, 2 * foot.y - goal.y, 0);
+        }
+
+        if (Turn(root, left, goal) > 0) {
+            return GetDistance(root, left) + GetDistance(left, goal);
+        }
+        if (Turn(root, right, goal) < 0) {
+            return GetDistance(root, right) + GetDistance(right, goal);
+        }
+        return GetDistance(root, goal);
+    }
+
+    // Where the ray from the root through the point of the edge a-b leaves the node a, b, c, as a position along
+    // a -> c -> b
+    static double FarPosition(const Vector3& root, const Vector3& point, const Vector3& a, const Vector3& b,
+                              const Vector3& c)
+    {
+        double dc = Turn(root, point, c);
+        if (dc < 0) {
+            double da = Turn(root, point, a);
+            return max(0.0, min(1.0, da / (da - dc)));
+        }
+        if (dc > 0) {
+            double db = Turn(root, point, b);
+            return 1 + max(0.0, min(1.0, dc / (dc - db)));
+        }
+        return 1;
+    }
+
+    Vector3 FarPoint(double position, int a, int b, int c)
+    {
+        vector<Vector3>& points = triangulation.points;
+        if (position <= 0) {
+            return points[a];
+        }
+        if (position >= 2) {
+            return points[b];
+        }
+        if (position == 1) {
+            return points[c];
+        }
+
+        Vector3 p1 = position < 1 ? points[a] : points[c];
+        Vector3 p2 = position < 1 ? points[c] : points[b];
+        double t = position < 1 ? position : position - 1;
+        return Vector3(p1.x + t * (p2.x - p1.x), p1.y + t * (p2.y - p1.y), 0);
+    }
+
+    // Index of pointId in the node
+    static int LocalIndex(TriangulationNode& node, int pointId)
+    {
+        if (node.points[0] == pointId) {
+            return 0;
+        }
+
+        return node.points[1] == pointId ? 1 : 2;
+    }
+
+    static bool Same(const Vector3& p1, const Vector3& p2)
+    {
+        return p1.x == p2.x && p1.y == p2.y;
+    }
+
+    // Positive if p3 is left of p1 -> p2
+    static double Turn(const Vector3& p1, const Vector3& p2, const Vector3& p3)
+    {
+        return (p2.x - p1.x) * (p3.y - p1.y) - (p2.y - p1.y) * (p3.x - p1.x);
+    }
+};
+
+#endif
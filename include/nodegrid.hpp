@@ -0,0 +1,82 @@
+#ifndef __NODEGRID__H
+#define __NODEGRID__H
+
+#include <vector>
+#include <algorithm>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+
+using namespace std;
+
+// Coarse grid over the centroids of the nodes, every cell keeps one of the nodes with the centroid inside it
+// Walks started from the cell of a point only cross a few nodes (see Triangulation::JumpAndWalk)
+class NodeGrid {
+public:
+    NodeGrid() : gridSize(0) {};
+
+    // Around nodesPerCell nodes per cell
+    void Build(Triangulation& triangulation, int nodesPerCell = 16)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        gridSize = 1;
+        while (gridSize * gridSize * nodesPerCell < nodes.size()) {
+            gridSize++;
+        }
+
+        const double FAR = 1e300;
+        gridMin = Vector3(FAR, FAR, 0);
+        gridMax = Vector3(-FAR, -FAR, 0);
+        for (int i = 0; i < nodes.size(); i++) {
+            Vector3 centroid = Centroid(triangulation, i);
+            gridMin = Vector3(min(gridMin.x, centroid.x), min(gridMin.y, centroid.y), 0);
+            gridMax = Vector3(max(gridMax.x, centroid.x), max(gridMax.y, centroid.y), 0);
+        }
+
+        cells.assign(gridSize * gridSize, -1);
+        for (int i = 0; i < nodes.size(); i++) {
+            cells[Cell(Centroid(triangulation, i))] = i;
+        }
+    }
+
+    // A node close to the point, -1 if there is none in its cell
+    int Find(const Vector3& point) const
+    {
+        return cells.empty() ? -1 : cells[Cell(point)];
+    }
+
+private:
+    vector<int> cells;
+    int gridSize;
+    Vector3 gridMin;
+    Vector3 gridMax;
+
+    static Vector3 Centroid(Triangulation& triangulation, int nodeId)
+    {
+        vector<Vector3>& points = triangulation.points;
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        Vector3& p1 = points[node.points[0]];
+        Vector3& p2 = points[node.points[1]];
+        Vector3& p3 = points[node.points[2]];
+        return Vector3((p1.x + p2.x + p3.x) / 3, (p1.y + p2.y + p3.y) / 3, 0);
+    }
+
+    int Cell(const Vector3& point) const
+    {
+        int x = Index(point.x, gridMin.x, gridMax.x);
+        int y = Index(point.y, gridMin.y, gridMax.y);
+        return y * gridSize + x;
+    }
+
+    int Index(double value, double min, double max) const
+    {
+        if (max <= min) {
+            return 0;
+        }
+
+        double index = (value - min) / (max - min) * gridSize;
+        return index < 0 ? 0 : (index >= gridSize ? gridSize - 1 : (int)index);
+    }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef __PARALLEL__H
+#define __PARALLEL__H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+
+// Number of threads used by the parallel parts of the triangulation
+int ThreadsCount()
+{
+    return max(1, (int)thread::hardware_concurrency());
+}
+
+// Splits [0, n) in one contiguous block per thread and calls func(thread, begin, end) on each
+// Returns once all the blocks are done
+template <typename Func>
+void ParallelFor(int n, Func func)
+{
+    int threadsCnt = ThreadsCount();
+    int blockSize = (n + threadsCnt - 1) / threadsCnt;
+    if (n <= 0 || threadsCnt == 1) {
+        func(0, 0, max(n, 0));
+        return;
+    }
+
+    vector<thread> threads;
+    for (int t = 0; t < threadsCnt; t++) {
+        int begin = min(n, t * blockSize);
+        int end = min(n, (t + 1) * blockSize);
+        threads.push_back(thread(func, t, begin, end));
+    }
+
+    for (int t = 0; t < threadsCnt; t++) {
+        threads[t].join();
+    }
+}
+
+// Sorts one block per thread, then merges neighbouring blocks in parallel until one is left
+template <typename T, typename Compare>
+void ParallelSort(vector<T>& items, Compare compare)
+{
+    int n = items.size();
+    int blockSize = (n + ThreadsCount() - 1) / ThreadsCount();
+    ParallelFor(n, [&items, &compare](int t, int begin, int end) {
+        sort(items.begin() + begin, items.begin() + end, compare);
+    });
+
+    for (int width = blockSize; width < n; width *= 2) {
+        int mergesCnt = (n + 2 * width - 1) / (2 * width);
+        ParallelFor(mergesCnt, [&items, &compare, n, width](int t, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                int first = i * 2 * width;
+                int middle = min(n, first + width);
+                int last = min(n, first + 2 * width);
+                inplace_merge(items.begin() + first, items.begin() + middle, items.begin() + last, compare);
+            }
+        });
+    }
+}
+
+// Marks which worker owns every node during a round of parallel work on a triangulation
+// Nodes claimed in an older round are free again, so nothing has to be cleared between rounds
+class NodeOwners {
+public:
+    static const int MAX_WORKERS = 1024;
+
+    NodeOwners() : round(0) {};
+
+    // Only call this between rounds
+    void Resize(int nodesCnt)
+    {
+        if (owners.size() < nodesCnt) {
+            owners.resize(nodesCnt, -1);
+        }
+    }
+
+    void NextRound()
+    {
+        round++;
+    }
+
+    // Returns false if the node is already owned by another worker in this round
+    bool Claim(int nodeId, int worker)
+    {
+        long long mine = round * MAX_WORKERS + worker;
+        long long current = __atomic_load_n(&owners[nodeId], __ATOMIC_ACQUIRE);
+        while (current != mine) {
+            if (current >= round * MAX_WORKERS) {
+                return false;
+            }
+
+            if (__atomic_compare_exchange_n(&owners[nodeId], &current, mine, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return true;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    vector<long long> owners;
+    long long round;
+};
+
+#endif
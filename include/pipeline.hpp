@@ -0,0 +1,690 @@
+#ifndef __PIPELINE__H
+#define __PIPELINE__H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <climits>
+#include <cmath>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "kernel.hpp"
+#include "bowyerwatson.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+// Fixed capacity queue used to pass work between two pipeline stages
+// Push blocks while the queue is full so a fast stage can't run too far ahead of a slow one
+template <typename T>
+class BoundedQueue {
+public:
+    BoundedQueue(int _capacity) : capacity(_capacity), closed(false) {};
+
+    void Push(T item)
+    {
+        unique_lock<mutex> lock(queueMutex);
+        notFull.wait(lock, [this] { return (int)items.size() < capacity; });
+        items.push_back(move(item));
+        notEmpty.notify_one();
+    }
+
+    // Returns false once the queue is closed and there is nothing left to pop
+    bool Pop(T& item)
+    {
+        unique_lock<mutex> lock(queueMutex);
+        notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return false;
+        }
+
+        item = move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Marks that no more items will be pushed
+    void Close()
+    {
+        unique_lock<mutex> lock(queueMutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    int capacity;
+    bool closed;
+    deque<T> items;
+    mutex queueMutex;
+    condition_variable notFull;
+    condition_variable notEmpty;
+};
+
+// A range of consecutive input points [begin, end) moving through the pipeline
+struct PointChunk {
+    int begin;
+    int end;
+
+    // Bounding box of all the points read up to the end of the chunk, if any of them is in the range of the kernel
+    bool bounded;
+    Vector3 boxMin;
+    Vector3 boxMax;
+
+    // Ids of the points in the chunk in insertion order (filled in by the sort stage)
+    vector<int> order;
+};
+
+// A triangle written to the output, with its id and the ids of its neighbours in the output
+struct FinalNode {
+    int id;
+    int points[3];
+    int neighbours[3];
+};
+
+// Finds the triangles no point left to insert can change, so they can be written while the insertion goes on:
+// once no point left is in the circumcircle of a triangle it is never part of a cavity again (streaming delaunay,
+// Isenburg et al.). The points left are counted on a grid over the whole input, and a triangle waits on one of
+// the cells its circle overlaps until all the points of the cell are in
+// A final triangle is written as soon as its neighbours are final too, the ids are given in the order the
+// triangles become final. The ones on the hull wait for Finish, their neighbours outside are only removed there
+class TriangleFinalizer {
+public:
+    static const int MAX_CHECKED_CELLS = 16;
+
+    Triangulation& triangulation;
+
+    // Set once the grid is built, Start needs the whole input
+    bool active;
+
+    // Set if a final triangle was removed after all (the tolerances of the double kernel). Finish gives the ids
+    // again and writes all the triangles over the ones already written then
+    bool failed;
+
+    // Output id of every node, -1 until it is final
+    vector<int> finalIds;
+
+    // Triangles ready to be written, taken by the pipeline after every chunk
+    vector<FinalNode> finalNodes;
+
+    TriangleFinalizer(Triangulation& _triangulation) :
+        triangulation(_triangulation), active(false), failed(false), finalCnt(0) {};
+
+    // Builds the grid over the box of the input and counts the points of pointIds, the ones left to insert, then
+    // looks for the final triangles among the current ones
+    void Start(const BowyerWatson<>& bowyerWatson, const vector<int>& pointIds, const Vector3& boxMin,
+               const Vector3& boxMax)
+    {
+        vector<Vector3>& points = triangulation.points;
+        for (int i = 0; i < 3; i++) {
+            superPoints[i] = bowyerWatson.superPoints[i];
+        }
+
+        // About 16 points per cell
+        gridMin = boxMin;
+        double width = max(boxMax.x - boxMin.x, EPS);
+        double height = max(boxMax.y - boxMin.y, EPS);
+        cellSize = sqrt(width * height / max(1.0, pointIds.size() / 16.0));
+        cellSize = max(cellSize, max(width, height) / 4096);
+        gridWidth = (int)(width / cellSize) + 1;
+        gridHeight = (int)(height / cellSize) + 1;
+
+        counts.assign(gridWidth * gridHeight, 0);
+        waiting.assign(gridWidth * gridHeight, vector<pair<int, int>>());
+        for (int i = 0; i < pointIds.size(); i++) {
+            counts[CellOf(points[pointIds[i]])]++;
+        }
+
+        active = true;
+        Reserve();
+        for (int i = 0; i < triangulation.nodes.size(); i++) {
+            Check(i);
+        }
+    }
+
+    // Updates the counts after pointId went through AddPointAndRetriangulate, newTriangles are the nodes it added
+    void Inserted(int pointId, const vector<int>& newTriangles)
+    {
+        if (!active || failed) {
+            return;
+        }
+
+        Reserve();
+        for (int i = 0; i < newTriangles.size(); i++) {
+            if (finalIds[newTriangles[i]] != -1) {
+                failed = true;
+                return;
+            }
+            stamps[newTriangles[i]]++;
+        }
+
+        int cell = CellOf(triangulation.points[pointId]);
+        counts[cell]--;
+        for (int i = 0; i < newTriangles.size(); i++) {
+            Check(newTriangles[i]);
+        }
+
+        if (counts[cell] > 0) {
+            return;
+        }
+
+        // The triangles waiting on the cell look for another one, unless they are gone already
+        vector<pair<int, int>> cellWaiting;
+        cellWaiting.swap(waiting[cell]);
+        for (int i = 0; i < cellWaiting.size(); i++) {
+            int nodeId = cellWaiting[i].first;
+            if (stamps[nodeId] == cellWaiting[i].second && finalIds[nodeId] == -1) {
+                Check(nodeId);
+            }
+        }
+    }
+
+    // Once all the points are in: the rest of the triangles are final, except the ones using a super triangle
+    // point. The nodes are moved to their output ids and the super triangle points removed, in the same way as
+    // BowyerWatson::RemoveSuperTriangle
+    void Finish(BowyerWatson<>& bowyerWatson)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        for (int i = 0; i < 3; i++) {
+            superPoints[i] = bowyerWatson.superPoints[i];
+        }
+
+        bowyerWatson.RestoreHull();
+        Reserve();
+        if (failed) {
+            finalIds.assign(nodes.size(), -1);
+            written.assign(nodes.size(), 0);
+            finalCnt = 0;
+        }
+
+        for (int i = 0; i < nodes.size(); i++) {
+            if (finalIds[i] == -1 && !HasSuperPoint(i)) {
+                finalIds[i] = finalCnt++;
+            }
+        }
+
+        for (int i = 0; i < nodes.size(); i++) {
+            if (finalIds[i] != -1 && !written[i]) {
+                Write(i);
+            }
+        }
+
+        vector<TriangulationNode> finalNodesOrder(finalCnt);
+        for (int i = 0; i < nodes.size(); i++) {
+            if (finalIds[i] == -1) {
+                continue;
+            }
+
+            TriangulationNode& node = finalNodesOrder[finalIds[i]];
+            node = nodes[i];
+            for (int x = 0; x < 3; x++) {
+                node.neighbours[x] = node.neighbours[x] == -1 ? -1 : finalIds[node.neighbours[x]];
+            }
+        }
+        nodes.swap(finalNodesOrder);
+
+        // No node uses them anymore, this only drops the points
+        triangulation.RemovePoint(superPoints[2]);
+        triangulation.RemovePoint(superPoints[1]);
+        triangulation.RemovePoint(superPoints[0]);
+        bowyerWatson.lastNode = 0;
+    }
+
+private:
+    int superPoints[3];
+    int finalCnt;
+
+    Vector3 gridMin;
+    double cellSize;
+    int gridWidth;
+    int gridHeight;
+
+    // Points left to insert in every cell, and the triangles waiting on it with the stamp they had then
+    vector<int> counts;
+    vector<vector<pair<int, int>>> waiting;
+
+    // Bumped every time a node id is reused for a new triangle, so the old waiting entries can be told apart
+    vector<int> stamps;
+    vector<char> written;
+
+    void Reserve()
+    {
+        int nodesCnt = triangulation.nodes.size();
+        if (finalIds.size() < nodesCnt) {
+            finalIds.resize(nodesCnt, -1);
+            stamps.resize(nodesCnt, 0);
+            written.resize(nodesCnt, 0);
+        }
+    }
+
+    int CellOf(const Vector3& point)
+    {
+        int x = min(max((int)((point.x - gridMin.x) / cellSize), 0), gridWidth - 1);
+        int y = min(max((int)((point.y - gridMin.y) / cellSize), 0), gridHeight - 1);
+        return y * gridWidth + x;
+    }
+
+    bool HasSuperPoint(int nodeId)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        for (int x = 0; x < 3; x++) {
+            int pointId = node.points[x];
+            if (pointId == superPoints[0] || pointId == superPoints[1] || pointId == superPoints[2]) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Makes the node final if no cell its circumcircle overlaps has points left, or has it wait on one of them
+    // Thin triangles with a huge circle would scan most of the grid every time, they wait for Finish instead
+    void Check(int nodeId)
+    {
+        if (HasSuperPoint(nodeId)) {
+            return;
+        }
+
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        Vector3 p1 = triangulation.points[node.points[0]];
+        Vector3 p2 = triangulation.points[node.points[1]];
+        Vector3 p3 = triangulation.points[node.points[2]];
+        if (det(p1, p2, p3) <= 0) {
+            return;
+        }
+
+        // The cells of the points are in the box of the circle, most of the time one of them still has points
+        for (int x = 0; x < 3; x++) {
+            int cell = CellOf(triangulation.points[node.points[x]]);
+            if (counts[cell] > 0) {
+                waiting[cell].push_back(make_pair(nodeId, stamps[nodeId]));
+                return;
+            }
+        }
+
+        // A bit larger than the circle, for the rounding errors of the center
+        Vector3 center = Circumcenter(p1, p2, p3);
+        double radius = GetDistance(center, p1) * (1 + 1e-9) + cellSize * 1e-6;
+        if (!isfinite(radius)) {
+            return;
+        }
+
+        int cellMin = CellOf(Vector3(center.x - radius, center.y - radius, 0));
+        int cellMax = CellOf(Vector3(center.x + radius, center.y + radius, 0));
+        if ((cellMax / gridWidth - cellMin / gridWidth + 1) * (cellMax % gridWidth - cellMin % gridWidth + 1) >
+            MAX_CHECKED_CELLS) {
+            return;
+        }
+
+        for (int y = cellMin / gridWidth; y <= cellMax / gridWidth; y++) {
+            for (int x = cellMin % gridWidth; x <= cellMax % gridWidth; x++) {
+                if (counts[y * gridWidth + x] > 0) {
+                    waiting[y * gridWidth + x].push_back(make_pair(nodeId, stamps[nodeId]));
+                    return;
+                }
+            }
+        }
+
+        finalIds[nodeId] = finalCnt++;
+        TryWrite(nodeId);
+        for (int x = 0; x < 3; x++) {
+            if (node.neighbours[x] != -1) {
+                TryWrite(node.neighbours[x]);
+            }
+        }
+    }
+
+    // Writes a final node once its neighbours are final, their ids never change then
+    void TryWrite(int nodeId)
+    {
+        if (finalIds[nodeId] == -1 || written[nodeId]) {
+            return;
+        }
+
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        for (int x = 0; x < 3; x++) {
+            if (node.neighbours[x] == -1 || finalIds[node.neighbours[x]] == -1) {
+                return;
+            }
+        }
+
+        Write(nodeId);
+    }
+
+    void Write(int nodeId)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        FinalNode finalNode;
+        finalNode.id = finalIds[nodeId];
+        for (int x = 0; x < 3; x++) {
+            finalNode.points[x] = node.points[x];
+            finalNode.neighbours[x] = node.neighbours[x] == -1 ? -1 : finalIds[node.neighbours[x]];
+        }
+
+        finalNodes.push_back(finalNode);
+        written[nodeId] = 1;
+    }
+};
+
+// Bowyer-Watson triangulation split into 4 stages running at the same time:
+//  - ingest: parses the input in chunks of points
+//  - sort: orders every chunk along a hilbert curve
+//  - insert: adds the sorted chunks to the triangulation
+//  - emit: formats the points, and the triangles the insertion is done with (see TriangleFinalizer), while the
+//    insertion is still running
+// The input is read into its own buffer, only the insert stage touches the triangulation
+// The super triangle grows with the box of the points read so far, and the triangles can only be final once the
+// whole input is read, so the ingest stage doesn't wait for the others. The order of the nodes in the output
+// depends on when it is done, the triangles don't
+class TriangulationPipeline {
+public:
+    Triangulation& triangulation;
+    int chunkSize;
+
+    BoundedQueue<PointChunk> parsedChunks;
+    BoundedQueue<PointChunk> sortedChunks;
+    BoundedQueue<PointChunk> emitChunks;
+    BoundedQueue<vector<FinalNode>> emitNodes;
+
+    // Points skipped by the insertion (see BowyerWatson::skippedPoints) and the ones out of the range of the kernel
+    vector<int> skippedPoints;
+
+    TriangulationPipeline(Triangulation& _triangulation, int _chunkSize = 4096, int queueSize = 8) :
+        triangulation(_triangulation), chunkSize(_chunkSize),
+        parsedChunks(INT_MAX), sortedChunks(queueSize), emitChunks(queueSize), emitNodes(queueSize),
+        inputRead(false) {};
+
+    void Run(istream& in, ostream& out)
+    {
+        int N;
+        in >> N;
+        input.resize(N);
+        outOfRange.assign(N, 0);
+        triangulation.points.resize(N);
+
+        string pointsOutput;
+        string nodesOutput;
+        vector<pair<size_t, int>> nodeLines;
+        thread ingestThread(&TriangulationPipeline::Ingest, this, ref(in), N);
+        thread sortThread(&TriangulationPipeline::Sort, this);
+        thread emitThread(&TriangulationPipeline::EmitPoints, this, ref(pointsOutput));
+        thread emitNodesThread(&TriangulationPipeline::EmitNodes, this, ref(nodesOutput), ref(nodeLines));
+
+        Insert();
+        emitNodes.Close();
+
+        ingestThread.join();
+        sortThread.join();
+        emitThread.join();
+        emitNodesThread.join();
+
+        // The triangles are written in the order they were done with, the lines are put back in id order (the
+        // ones next to each other in both in one go)
+        out << triangulation.points.size() << " " << triangulation.nodes.size() << "\n";
+        out << pointsOutput;
+        for (int i = 0; i < triangulation.nodes.size();) {
+            size_t begin = nodeLines[i].first;
+            size_t end = begin;
+            for (; i < triangulation.nodes.size() && nodeLines[i].first == end; i++) {
+                end += nodeLines[i].second;
+            }
+            out.write(nodesOutput.data() + begin, end - begin);
+        }
+        out.flush();
+    }
+
+private:
+    vector<Vector3> input;
+
+    // Points left out because the kernel can't represent them
+    vector<char> outOfRange;
+
+    // Set by the ingest stage once the whole input is read, with the box of the points in range
+    mutex inputMutex;
+    bool inputRead;
+    bool inputBounded;
+    Vector3 inputMin;
+    Vector3 inputMax;
+
+    void Ingest(istream& in, int N)
+    {
+        bool bounded = false;
+        Vector3 boxMin, boxMax;
+        for (int begin = 0; begin < N; begin += chunkSize) {
+            PointChunk chunk;
+            chunk.begin = begin;
+            chunk.end = min(N, begin + chunkSize);
+
+            for (int i = chunk.begin; i < chunk.end; i++) {
+                double x, y;
+                in >> x >> y;
+                input[i] = Vector3(x, y, 0);
+                outOfRange[i] = !DefaultKernel().Quantize(input[i]);
+                if (outOfRange[i]) {
+                    continue;
+                }
+
+                if (!bounded) {
+                    boxMin = boxMax = input[i];
+                    bounded = true;
+                }
+                boxMin = Vector3(min(boxMin.x, input[i].x), min(boxMin.y, input[i].y), 0);
+                boxMax = Vector3(max(boxMax.x, input[i].x), max(boxMax.y, input[i].y), 0);
+            }
+
+            chunk.bounded = bounded;
+            chunk.boxMin = boxMin;
+            chunk.boxMax = boxMax;
+            emitChunks.Push(chunk);
+            parsedChunks.Push(chunk);
+        }
+
+        {
+            unique_lock<mutex> lock(inputMutex);
+            inputRead = true;
+            inputBounded = bounded;
+            inputMin = boxMin;
+            inputMax = boxMax;
+        }
+
+        emitChunks.Close();
+        parsedChunks.Close();
+    }
+
+    void Sort()
+    {
+        PointChunk chunk;
+        while (parsedChunks.Pop(chunk)) {
+            chunk.order.clear();
+            for (int i = chunk.begin; i < chunk.end; i++) {
+                if (!outOfRange[i]) {
+                    chunk.order.push_back(i);
+                }
+            }
+
+            SpatialSort(input, chunk.order);
+            sortedChunks.Push(chunk);
+        }
+
+        sortedChunks.Close();
+    }
+
+    void Insert()
+    {
+        BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+        TriangleFinalizer finalizer = TriangleFinalizer(triangulation);
+
+        // Every point given to the insertion so far, to start over with a bigger super triangle
+        vector<int> inserted;
+        vector<char> isInserted(input.size(), 0);
+
+        PointChunk chunk;
+        bool superTriangle = false;
+        while (sortedChunks.Pop(chunk)) {
+            for (int i = chunk.begin; i < chunk.end; i++) {
+                triangulation.points[i] = input[i];
+            }
+
+            if (chunk.bounded && !superTriangle) {
+                bowyerWatson.GenerateSuperTriangle(chunk.boxMin, chunk.boxMax);
+                superTriangle = true;
+            } else if (chunk.bounded && !InsideSuperTriangle(bowyerWatson, chunk.boxMin, chunk.boxMax)) {
+                Grow(bowyerWatson, chunk.boxMin, chunk.boxMax, inserted);
+            }
+
+            if (superTriangle && !finalizer.active) {
+                StartFinalizer(bowyerWatson, finalizer, isInserted);
+            }
+
+            for (int i = 0; i < chunk.order.size(); i++) {
+                bowyerWatson.AddPointAndRetriangulate(chunk.order[i]);
+                inserted.push_back(chunk.order[i]);
+                isInserted[chunk.order[i]] = 1;
+                finalizer.Inserted(chunk.order[i], bowyerWatson.newTriangles);
+            }
+
+            if (!finalizer.finalNodes.empty()) {
+                emitNodes.Push(finalizer.finalNodes);
+                finalizer.finalNodes.clear();
+            }
+        }
+
+        skippedPoints.clear();
+        for (int i = 0; i < input.size(); i++) {
+            if (outOfRange[i]) {
+                skippedPoints.push_back(i);
+            }
+        }
+
+        if (!superTriangle) {
+            return;
+        }
+
+        finalizer.Finish(bowyerWatson);
+        emitNodes.Push(finalizer.finalNodes);
+        skippedPoints.insert(skippedPoints.end(), bowyerWatson.skippedPoints.begin(),
+                             bowyerWatson.skippedPoints.end());
+    }
+
+    // True if the box is strictly inside the super triangle, so all the points in it can be inserted
+    bool InsideSuperTriangle(BowyerWatson<>& bowyerWatson, const Vector3& boxMin, const Vector3& boxMax)
+    {
+        Vector3 corners[4] = {boxMin, Vector3(boxMax.x, boxMin.y, 0), boxMax, Vector3(boxMin.x, boxMax.y, 0)};
+        for (int i = 0; i < 3; i++) {
+            Vector3 p1 = triangulation.points[bowyerWatson.superPoints[i]];
+            Vector3 p2 = triangulation.points[bowyerWatson.superPoints[(i + 1) % 3]];
+            for (int j = 0; j < 4; j++) {
+                if (bowyerWatson.filtered.Orient(p1, p2, corners[j]) <= 0) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // The points read so far are out of the super triangle: starts over with one around all of them. It is 10 times
+    // the size of their box, so the points have to spread a lot before the next time and the points inserted
+    // again add up to a few times the input at most
+    void Grow(BowyerWatson<>& bowyerWatson, const Vector3& boxMin, const Vector3& boxMax, const vector<int>& inserted)
+    {
+        triangulation.nodes.clear();
+        triangulation.points.resize(input.size());
+        bowyerWatson.skippedPoints.clear();
+        bowyerWatson.duplicatePoints.clear();
+        bowyerWatson.freeNodes.clear();
+
+        bowyerWatson.GenerateSuperTriangle(boxMin, boxMax);
+        bowyerWatson.AddPointsAndRetriangulate(inserted);
+    }
+
+    // Starts finding the final triangles once the whole input is read and inside the super triangle, so it never
+    // has to grow again
+    void StartFinalizer(BowyerWatson<>& bowyerWatson, TriangleFinalizer& finalizer, const vector<char>& isInserted)
+    {
+        {
+            unique_lock<mutex> lock(inputMutex);
+            if (!inputRead || !inputBounded || !InsideSuperTriangle(bowyerWatson, inputMin, inputMax)) {
+                return;
+            }
+        }
+
+        vector<int> left;
+        for (int i = 0; i < input.size(); i++) {
+            if (!outOfRange[i] && !isInserted[i]) {
+                left.push_back(i);
+            }
+        }
+
+        // The points of the chunks still in the queues aren't copied yet
+        for (int i = 0; i < left.size(); i++) {
+            triangulation.points[left[i]] = input[left[i]];
+        }
+        finalizer.Start(bowyerWatson, left, inputMin, inputMax);
+    }
+
+    // Points never change after being read so they can be written out while the insertion runs
+    void EmitPoints(string& output)
+    {
+        PointChunk chunk;
+        while (emitChunks.Pop(chunk)) {
+            ostringstream buffer;
+            for (int i = chunk.begin; i < chunk.end; i++) {
+                Vector3 point = input[i];
+                buffer << Triangulation::Format(point.x) << " " << Triangulation::Format(point.y) << " "
+                       << Triangulation::Format(point.z) << "\n";
+            }
+            output += buffer.str();
+        }
+    }
+
+    // Formats the triangles in the same way as Triangulation::Print, in the order they come, one block per thread
+    // (most of them come at once in the end when the input isn't sorted). lines has the offset and length of the
+    // line of every node id
+    void EmitNodes(string& output, vector<pair<size_t, int>>& lines)
+    {
+        vector<FinalNode> finalNodes;
+        while (emitNodes.Pop(finalNodes)) {
+            vector<string> blocks(ThreadsCount());
+            vector<pair<size_t, int>> blockLines(finalNodes.size());
+            ParallelFor(finalNodes.size(), [&finalNodes, &blocks, &blockLines](int t, int begin, int end) {
+                ostringstream buffer;
+                for (int i = begin; i < end; i++) {
+                    size_t lineBegin = buffer.tellp();
+                    for (int x = 0; x < 3; x++) {
+                        buffer << finalNodes[i].points[x] << " ";
+                    }
+
+                    for (int x = 0; x < 3; x++) {
+                        buffer << finalNodes[i].neighbours[x] << " ";
+                    }
+                    buffer << "\n";
+                    blockLines[i] = make_pair(lineBegin, (int)((size_t)buffer.tellp() - lineBegin));
+                }
+                blocks[t] = buffer.str();
+            });
+
+            // The blocks are contiguous ranges of the batch, in thread order
+            int blockSize = (finalNodes.size() + blocks.size() - 1) / blocks.size();
+            size_t blockOffset = 0;
+            for (int i = 0; i < finalNodes.size(); i++) {
+                if (i % blockSize == 0) {
+                    blockOffset = output.size();
+                    output += blocks[i / blockSize];
+                }
+                if (lines.size() <= finalNodes[i].id) {
+                    lines.resize(finalNodes[i].id + 1);
+                }
+                lines[finalNodes[i].id] = make_pair(blockOffset + blockLines[i].first, blockLines[i].second);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,354 @@
+#ifndef __RANGEQUERY__H
+#define __RANGEQUERY__H
+
+#include <vector>
+#include <algorithm>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include "nodegrid.hpp"
+
+using namespace std;
+
+enum RangeShape {
+    RANGE_RECTANGLE,
+    RANGE_CIRCLE
+};
+
+// Axis aligned rectangle between corner and otherCorner, or circle around corner
+struct RangeQuery {
+    RangeShape shape;
+    Vector3 corner;
+    Vector3 otherCorner;
+    double radius;
+
+    static RangeQuery Rectangle(Vector3 min, Vector3 max)
+    {
+        RangeQuery query = { RANGE_RECTANGLE, min, max, 0 };
+        return query;
+    }
+
+    static RangeQuery Circle(Vector3 center, double radius)
+    {
+        RangeQuery query = { RANGE_CIRCLE, center, center, radius };
+        return query;
+    }
+
+    // Axis aligned box around the range
+    void Bounds(Vector3& boxMin, Vector3& boxMax) const
+    {
+        double margin = shape == RANGE_CIRCLE ? radius : 0;
+        boxMin = Vector3(corner.x - margin, corner.y - margin, 0);
+        boxMax = Vector3(otherCorner.x + margin, otherCorner.y + margin, 0);
+    }
+
+    Vector3 Center() const
+    {
+        return Vector3((corner.x + otherCorner.x) / 2, (corner.y + otherCorner.y) / 2, 0);
+    }
+
+    bool Contains(const Vector3& point) const
+    {
+        if (shape == RANGE_CIRCLE) {
+            double dx = point.x - corner.x;
+            double dy = point.y - corner.y;
+            return dx * dx + dy * dy <= radius * radius;
+        }
+
+        return point.x >= corner.x && point.x <= otherCorner.x && point.y >= corner.y && point.y <= otherCorner.y;
+    }
+
+    // True if some point of the segment p1-p2 is inside the range
+    bool Intersects(const Vector3& p1, const Vector3& p2) const
+    {
+        double dx = p2.x - p1.x;
+        double dy = p2.y - p1.y;
+        if (shape == RANGE_CIRCLE) {
+            // Closest point of the segment to the center
+            double length = dx * dx + dy * dy;
+            double t = length > 0 ? ((corner.x - p1.x) * dx + (corner.y - p1.y) * dy) / length : 0;
+            t = max(0.0, min(1.0, t));
+            return Contains(Vector3(p1.x + t * dx, p1.y + t * dy, 0));
+        }
+
+        // Clip the segment against the slabs of the rectangle (Liang-Barsky)
+        double enter = 0;
+        double leave = 1;
+        return Clip(-dx, p1.x - corner.x, enter, leave) && Clip(dx, otherCorner.x - p1.x, enter, leave) &&
+               Clip(-dy, p1.y - corner.y, enter, leave) && Clip(dy, otherCorner.y - p1.y, enter, leave);
+    }
+
+private:
+    static bool Clip(double direction, double distance, double& enter, double& leave)
+    {
+        if (direction == 0) {
+            return distance >= 0;
+        }
+
+        double t = distance / direction;
+        if (direction < 0) {
+            enter = max(enter, t);
+        } else {
+            leave = min(leave, t);
+        }
+        return enter <= leave;
+    }
+};
+
+// The edges of the hull (the node and the index of the missing neighbour) bucketed on a grid over the box of the
+// hull, every edge in all the cells its box overlaps. The cells are stored one after the other (cellStart)
+class HullEdgeGrid {
+public:
+    vector<pair<int, int>> edges;
+
+    HullEdgeGrid() : gridSize(0) {};
+
+    void Build(Triangulation& triangulation)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        edges.clear();
+        for (int i = 0; i < nodes.size(); i++) {
+            for (int x = 0; x < 3; x++) {
+                if (nodes[i].neighbours[x] == -1) {
+                    edges.push_back(make_pair(i, x));
+                }
+            }
+        }
+
+        // The hull is a loop, so about 4 * gridSize cells have edges. A few edges per cell, but not more than
+        // 4 times the edges in all
+        gridSize = max(1, min((int)edges.size() / 4, (int)sqrt(4.0 * edges.size())));
+        for (int i = 0; i < edges.size(); i++) {
+            TriangulationNode& node = nodes[edges[i].first];
+            for (int y = 1; y <= 2; y++) {
+                Vector3& point = points[node.points[(edges[i].second + y) % 3]];
+                gridMin = i == 0 && y == 1 ? point : Vector3(min(gridMin.x, point.x), min(gridMin.y, point.y), 0);
+                gridMax = i == 0 && y == 1 ? point : Vector3(max(gridMax.x, point.x), max(gridMax.y, point.y), 0);
+            }
+        }
+
+        // Count the edges of every cell, then fill them in
+        cellStart.assign(gridSize * gridSize + 1, 0);
+        for (int pass = 0; pass < 2; pass++) {
+            vector<int> filled(cellStart.begin(), cellStart.end() - 1);
+            if (pass == 1) {
+                cellEdges.resize(cellStart.back());
+            }
+
+            for (int i = 0; i < edges.size(); i++) {
+                Vector3 edgeMin, edgeMax;
+                EdgeBounds(triangulation, i, edgeMin, edgeMax);
+                for (int y = Index(edgeMin.y, gridMin.y, gridMax.y); y <= Index(edgeMax.y, gridMin.y, gridMax.y); y++) {
+                    for (int x = Index(edgeMin.x, gridMin.x, gridMax.x); x <= Index(edgeMax.x, gridMin.x, gridMax.x);
+                         x++) {
+                        if (pass == 0) {
+                            cellStart[y * gridSize + x + 1]++;
+                        } else {
+                            cellEdges[filled[y * gridSize + x]++] = i;
+                        }
+                    }
+                }
+            }
+
+            for (int c = 0; pass == 0 && c < gridSize * gridSize; c++) {
+                cellStart[c + 1] += cellStart[c];
+            }
+        }
+    }
+
+    // Calls func(edge) on the edges in the cells the box overlaps, an edge can come more than once. Nothing if the
+    // box misses the box of the hull
+    template <typename Func>
+    void ForEachEdge(const Vector3& boxMin, const Vector3& boxMax, Func func) const
+    {
+        if (edges.empty() || boxMax.x < gridMin.x || boxMax.y < gridMin.y || boxMin.x > gridMax.x ||
+            boxMin.y > gridMax.y) {
+            return;
+        }
+
+        for (int y = Index(boxMin.y, gridMin.y, gridMax.y); y <= Index(boxMax.y, gridMin.y, gridMax.y); y++) {
+            for (int x = Index(boxMin.x, gridMin.x, gridMax.x); x <= Index(boxMax.x, gridMin.x, gridMax.x); x++) {
+                for (int i = cellStart[y * gridSize + x]; i < cellStart[y * gridSize + x + 1]; i++) {
+                    func(cellEdges[i]);
+                }
+            }
+        }
+    }
+
+private:
+    vector<int> cellStart;
+    vector<int> cellEdges;
+    int gridSize;
+    Vector3 gridMin;
+    Vector3 gridMax;
+
+    void EdgeBounds(Triangulation& triangulation, int edge, Vector3& edgeMin, Vector3& edgeMax) const
+    {
+        TriangulationNode& node = triangulation.nodes[edges[edge].first];
+        Vector3& p1 = triangulation.points[node.points[(edges[edge].second + 1) % 3]];
+        Vector3& p2 = triangulation.points[node.points[(edges[edge].second + 2) % 3]];
+        edgeMin = Vector3(min(p1.x, p2.x), min(p1.y, p2.y), 0);
+        edgeMax = Vector3(max(p1.x, p2.x), max(p1.y, p2.y), 0);
+    }
+
+    int Index(double value, double min, double max) const
+    {
+        if (max <= min) {
+            return 0;
+        }
+
+        double index = (value - min) / (max - min) * gridSize;
+        return index < 0 ? 0 : (index >= gridSize ? gridSize - 1 : (int)index);
+    }
+};
+
+// Finds the triangles intersecting a rectangle or a circle: the triangle containing the center of the range is
+// located with a short walk from a coarse grid of nodes, then the search floods to the neighbours across the edges
+// intersecting the range, so a query costs about the size of its result. Visited nodes are stamped with the
+// number of the query instead of being cleared after it
+// Queries are answered in batches on all the threads, every thread with its own marks and walk start
+// Note on a non convex triangulation (ex. Bowyer-Watson after the super triangle is removed) the parts of a range
+// only connected through the outside of the triangulation might be missed. Call Update after editing the nodes
+template <typename Kernel = DefaultKernel>
+class RangeQueries {
+public:
+    Triangulation& triangulation;
+    Kernel kernel;
+
+    RangeQueries(Triangulation& _triangulation, Kernel _kernel = Kernel()) :
+        triangulation(_triangulation), kernel(_kernel), states(ThreadsCount())
+    {
+        Update();
+    };
+
+    // Finds the edges of the hull and the start nodes of the walks again, and makes room for the marks of new nodes
+    void Update()
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        hullGrid.Build(triangulation);
+        grid.Build(triangulation);
+
+        for (int t = 0; t < states.size(); t++) {
+            states[t].marks.resize(nodes.size(), 0);
+            if (states[t].lastNode >= nodes.size()) {
+                states[t].lastNode = 0;
+            }
+        }
+    }
+
+    // Writes the ids of the nodes intersecting the range into result. Returns how many there are, or -1 if
+    // there are more than capacity
+    int Query(const RangeQuery& query, int* result, int capacity)
+    {
+        return Query(query, result, capacity, states[0]);
+    }
+
+    // Answers the queries on all the threads. The result of query i goes to results + i * capacity and its
+    // count (or -1) to counts[i]
+    void QueryBatch(const vector<RangeQuery>& queries, int* results, int capacity, int* counts)
+    {
+        ParallelFor(queries.size(), [&](int t, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                counts[i] = Query(queries[i], results + (long long)i * capacity, capacity, states[t]);
+            }
+        });
+    }
+
+private:
+    struct QueryState {
+        vector<unsigned int> marks;
+        unsigned int epoch;
+        int lastNode;
+
+        QueryState() : epoch(0), lastNode(0) {};
+    };
+
+    vector<QueryState> states;
+    HullEdgeGrid hullGrid;
+    NodeGrid grid;
+
+    int Query(const RangeQuery& query, int* result, int capacity, QueryState& state)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        if (nodes.empty() || (query.shape == RANGE_RECTANGLE &&
+            (query.corner.x > query.otherCorner.x || query.corner.y > query.otherCorner.y))) {
+            return 0;
+        }
+
+        // The marks are only cleared when the epoch wraps around
+        if (++state.epoch == 0) {
+            fill(state.marks.begin(), state.marks.end(), 0);
+            state.epoch = 1;
+        }
+
+        // The result doubles as the queue of the flood
+        int found = 0;
+        Vector3 center = query.Center();
+        int start = grid.Find(center);
+        int seed = triangulation.JumpAndWalk(center, start != -1 ? start : state.lastNode, kernel);
+        if (seed != -1) {
+            state.lastNode = seed;
+            if (!Visit(seed, result, capacity, found, state)) {
+                return -1;
+            }
+        } else {
+            // The center is outside, the range can only reach the triangulation across the hull. Only the hull
+            // edges next to the range are checked, a range away from the hull costs nothing
+            Vector3 boxMin, boxMax;
+            query.Bounds(boxMin, boxMax);
+            bool full = false;
+            hullGrid.ForEachEdge(boxMin, boxMax, [&](int edge) {
+                int nodeId = hullGrid.edges[edge].first;
+                int x = hullGrid.edges[edge].second;
+                TriangulationNode& node = nodes[nodeId];
+                if (full || state.marks[nodeId] == state.epoch ||
+                    !query.Intersects(points[node.points[(x + 1) % 3]], points[node.points[(x + 2) % 3]])) {
+                    return;
+                }
+
+                full = !Visit(nodeId, result, capacity, found, state);
+            });
+
+            if (full) {
+                return -1;
+            }
+        }
+
+        for (int crt = 0; crt < found; crt++) {
+            TriangulationNode& node = nodes[result[crt]];
+            for (int x = 0; x < 3; x++) {
+                int neighbour = node.neighbours[x];
+                if (neighbour == -1 || state.marks[neighbour] == state.epoch) {
+                    continue;
+                }
+
+                if (query.Intersects(points[node.points[(x + 1) % 3]], points[node.points[(x + 2) % 3]]) &&
+                    !Visit(neighbour, result, capacity, found, state)) {
+                    return -1;
+                }
+            }
+        }
+
+        return found;
+    }
+
+    bool Visit(int nodeId, int* result, int capacity, int& found, QueryState& state)
+    {
+        if (state.marks[nodeId] == state.epoch) {
+            return true;
+        }
+        if (found == capacity) {
+            return false;
+        }
+
+        state.marks[nodeId] = state.epoch;
+        result[found++] = nodeId;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,507 @@
+#ifndef __REFINEMENT__H
+#define __REFINEMENT__H
+
+#include <vector>
+#include <queue>
+#include <unordered_set>
+#include <cmath>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+
+using namespace std;
+
+// Triangle waiting to be fixed. The points are kept to detect when the node was reused by another insertion
+struct BadTriangle {
+    double priority;
+    int nodeId;
+    int points[3];
+
+    bool operator<(const BadTriangle& other) const
+    {
+        return priority < other.priority;
+    }
+};
+
+// Ruppert style delaunay refinement: adds points to a triangulation until every triangle inside the convex hull
+// has all its angles above minAngle and its area below maxArea
+// The convex hull edges are the boundary segments, with a segment between every two points along the hull (points
+// on a hull edge split it). They are split at their midpoint whenever a point gets inside their diametral circle,
+// so they stay edges of the triangulation. When the middle is too close to a point next to the segment, the
+// segment is split at that point instead. The thin triangle left between it and the hull is outside the boundary
+// and isn't refined, no triangle with edges above minEdgeLength could fill it
+// The walks and the encroachment tests use the filtered predicates, like the insertions
+// Note this works on the triangulation before the super triangle is removed
+template <typename Kernel = DefaultKernel>
+class DelaunayRefinement {
+public:
+    BowyerWatson<Kernel>& bowyerWatson;
+    Triangulation& triangulation;
+
+    // Quality targets, maxArea <= 0 means there is no area limit
+    double minAngle;
+    double maxArea;
+
+    // Insert off-centers instead of circumcenters when they are closer to the shortest edge
+    // They give the same quality with fewer points
+    bool useOffCenters;
+
+    // Stop after adding this many points, the angle guarantee only holds for minAngle up to ~20.7 degrees
+    int maxNewPoints;
+
+    // No edges shorter than this are created. Below it the EPS tolerances of the predicates
+    // decide the geometry, so triangles around smaller input features are left as they are
+    double minEdgeLength;
+
+    DelaunayRefinement(BowyerWatson<Kernel>& _bowyerWatson, double _minAngle, double _maxArea = 0) :
+        bowyerWatson(_bowyerWatson), triangulation(_bowyerWatson.triangulation),
+        minAngle(_minAngle), maxArea(_maxArea), useOffCenters(true), maxNewPoints(10000000), minEdgeLength(0.1) {};
+
+    // Refines the triangulation of the first pointsCnt points and returns how many points were added
+    int Refine(int pointsCnt)
+    {
+        // Radius-edge ratio matching minAngle (R / shortest edge = 1 / (2 * sin(minAngle)))
+        maxRatio = 1 / (2 * sin(minAngle * M_PI / 180));
+        addedPoints = 0;
+
+        // Collinear points have no triangles to refine
+        vector<int> hull;
+        bowyerWatson.ComputeHull(hull, pointsCnt);
+        if (hull.size() < 3) {
+            return 0;
+        }
+
+        for (int i = 0; i < hull.size(); i++) {
+            AddSegment(hull[i], hull[(i + 1) % hull.size()]);
+        }
+
+        for (int i = 0; i < triangulation.nodes.size(); i++) {
+            CheckTriangle(i);
+        }
+
+        SplitEncroachedSegments();
+        while (!badTriangles.empty() && addedPoints < maxNewPoints) {
+            BadTriangle triangle = badTriangles.top();
+            badTriangles.pop();
+
+            if (IsStale(triangle)) {
+                continue;
+            }
+
+            bool fixed = FixTriangle(triangle.nodeId);
+            SplitEncroachedSegments();
+
+            // A segment had to be split first, try again if the triangle is still there
+            if (!fixed && !IsStale(triangle)) {
+                CheckTriangle(triangle.nodeId);
+            }
+        }
+
+        return addedPoints;
+    }
+
+private:
+    double maxRatio;
+    int addedPoints;
+
+    priority_queue<BadTriangle> badTriangles;
+
+    // Boundary segments stored as SegmentKey(p1, p2), in the counterclockwise direction of the hull
+    unordered_set<long long> segments;
+    vector<pair<int, int>> encroachedSegments;
+
+    long long SegmentKey(int p1, int p2)
+    {
+        return ((long long)p1 << 32) | p2;
+    }
+
+    bool IsSegment(int p1, int p2)
+    {
+        return segments.count(SegmentKey(p1, p2)) > 0 || segments.count(SegmentKey(p2, p1)) > 0;
+    }
+
+    // True if the node is on the outer side of one of the segments, so outside the boundary
+    bool IsOutside(int nodeId)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        for (int x = 0; x < 3; x++) {
+            if (segments.count(SegmentKey(node.points[(x + 2) % 3], node.points[(x + 1) % 3])) > 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void AddSegment(int p1, int p2)
+    {
+        segments.insert(SegmentKey(p1, p2));
+        encroachedSegments.push_back(make_pair(p1, p2));
+    }
+
+    // Checks if point is inside the diametral circle of the segment p1, p2
+    bool Encroaches(int p1, int p2, Vector3 point)
+    {
+        Vector3 a = triangulation.points[p1] - point;
+        Vector3 b = triangulation.points[p2] - point;
+        return a.x * b.x + a.y * b.y < 0;
+    }
+
+    bool IsStale(const BadTriangle& triangle)
+    {
+        if (triangle.nodeId >= triangulation.nodes.size()) {
+            return true;
+        }
+
+        TriangulationNode& node = triangulation.nodes[triangle.nodeId];
+        return node.points[0] != triangle.points[0] || node.points[1] != triangle.points[1] ||
+               node.points[2] != triangle.points[2];
+    }
+
+    // Adds the node to the queue if it is inside the boundary and doesn't meet the quality targets
+    void CheckTriangle(int nodeId)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        for (int x = 0; x < 3; x++) {
+            if (bowyerWatson.IsSuperPoint(node.points[x])) {
+                return;
+            }
+        }
+        if (IsOutside(nodeId)) {
+            return;
+        }
+
+        Vector3 p1 = triangulation.points[node.points[0]];
+        Vector3 p2 = triangulation.points[node.points[1]];
+        Vector3 p3 = triangulation.points[node.points[2]];
+
+        double shortestEdge = min(GetDistance(p1, p2), min(GetDistance(p2, p3), GetDistance(p3, p1)));
+        double radius = GetDistance(Circumcenter(p1, p2, p3), p1);
+        double area = fabs(det(p1, p2, p3)) / 2;
+
+        // How far the triangle is from the targets, the worst triangles are fixed first
+        double priority = radius / shortestEdge / maxRatio;
+        if (maxArea > 0) {
+            priority = max(priority, area / maxArea);
+        }
+
+        if (priority > 1 + EPS) {
+            BadTriangle triangle;
+            triangle.priority = priority;
+            triangle.nodeId = nodeId;
+            for (int x = 0; x < 3; x++) {
+                triangle.points[x] = node.points[x];
+            }
+            badTriangles.push(triangle);
+        }
+    }
+
+    // Checks the triangles created by the last insertion
+    void CheckNewTriangles(int pointId)
+    {
+        addedPoints++;
+        for (int i = 0; i < bowyerWatson.newTriangles.size(); i++) {
+            int nodeId = bowyerWatson.newTriangles[i];
+            CheckTriangle(nodeId);
+
+            // The edge opposite to the new point is on the border of the cavity, so it might be a segment
+            // the new point is too close to
+            TriangulationNode& node = triangulation.nodes[nodeId];
+            if (IsSegment(node.points[1], node.points[2]) &&
+                Encroaches(node.points[1], node.points[2], triangulation.points[pointId])) {
+                encroachedSegments.push_back(make_pair(node.points[1], node.points[2]));
+            }
+        }
+    }
+
+    void SplitEncroachedSegments()
+    {
+        while (!encroachedSegments.empty()) {
+            pair<int, int> segment = encroachedSegments.back();
+            encroachedSegments.pop_back();
+
+            int onSegment = -1;
+            int nextToSegment = -1;
+            if (!IsSegment(segment.first, segment.second) ||
+                !IsEncroached(segment.first, segment.second, onSegment, nextToSegment)) {
+                continue;
+            }
+
+            // When the middle is too close to the point next to the segment, the segment goes through the point
+            if (onSegment != -1) {
+                SplitSegment(segment.first, segment.second, onSegment);
+            } else if (!SplitSegment(segment.first, segment.second) && nextToSegment != -1) {
+                SplitSegment(segment.first, segment.second, nextToSegment);
+            }
+        }
+    }
+
+    // A segment is encroached if it is missing from the triangulation or if the point opposite to it
+    // in the triangle inside the boundary is in its diametral circle
+    // If that point is right on the segment it is returned in onSegment, if it is closer than minEdgeLength to
+    // the segment in nextToSegment
+    bool IsEncroached(int p1, int p2, int& onSegment, int& nextToSegment)
+    {
+        Vector3 middle = (triangulation.points[p1] + triangulation.points[p2]) * 0.5;
+        int nodeId = triangulation.JumpAndWalk(middle, bowyerWatson.lastNode, bowyerWatson.filtered);
+        if (nodeId == -1) {
+            return true;
+        }
+
+        // The middle is on the segment, so it is found in one of the two triangles sharing it
+        for (int side = 0; side < 2; side++) {
+            TriangulationNode& node = triangulation.nodes[nodeId];
+            int opposite = -1;
+            int found = 0;
+            for (int x = 0; x < 3; x++) {
+                if (node.points[x] == p1 || node.points[x] == p2) {
+                    found++;
+                } else {
+                    opposite = x;
+                }
+            }
+
+            if (found != 2) {
+                return true;
+            }
+
+            int pointId = node.points[opposite];
+            if (!bowyerWatson.IsSuperPoint(pointId) && !IsOutside(nodeId)) {
+                Vector3& a = triangulation.points[p1];
+                Vector3& b = triangulation.points[p2];
+                Vector3& point = triangulation.points[pointId];
+                if (!Encroaches(p1, p2, point)) {
+                    return false;
+                }
+
+                if (bowyerWatson.filtered.Orient(a, b, point) == 0) {
+                    onSegment = pointId;
+                } else if (fabs(det(a, b, point)) < minEdgeLength * GetDistance(a, b)) {
+                    nextToSegment = pointId;
+                }
+                return true;
+            }
+
+            nodeId = node.neighbours[opposite];
+            if (nodeId == -1) {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    // Splits the segment at its middle, or at splitPoint if it is already on (or next to) the segment
+    // Returns false if one of the pieces would be shorter than minEdgeLength
+    bool SplitSegment(int p1, int p2, int splitPoint = -1)
+    {
+        // The pieces keep the direction of the segment
+        if (segments.count(SegmentKey(p1, p2)) == 0) {
+            swap(p1, p2);
+        }
+
+        if (splitPoint == -1) {
+            if (GetDistance(triangulation.points[p1], triangulation.points[p2]) < 2 * minEdgeLength) {
+                return false;
+            }
+
+            Vector3 middle = (triangulation.points[p1] + triangulation.points[p2]) * 0.5;
+            if (!bowyerWatson.kernel.Quantize(middle)) {
+                return false;
+            }
+
+            int nodeId = triangulation.JumpAndWalk(middle, bowyerWatson.lastNode, bowyerWatson.filtered);
+            if (nodeId == -1) {
+                return false;
+            }
+
+            int pointId = triangulation.AddPoint(middle);
+            bowyerWatson.ReserveWorkspace();
+            splitPoint = bowyerWatson.FindDuplicate(nodeId, pointId);
+            if (splitPoint != -1) {
+                // Already a point in the middle, use it instead
+                triangulation.points.pop_back();
+            } else {
+                if (!bowyerWatson.FindCavity(nodeId, pointId) || RemovesPoints() || TooClose(middle)) {
+                    bowyerWatson.ClearCavity();
+                    triangulation.points.pop_back();
+                    return false;
+                }
+
+                bowyerWatson.FillCavity(pointId);
+                CheckNewTriangles(pointId);
+                splitPoint = pointId;
+            }
+        }
+
+        if (splitPoint == p1 || splitPoint == p2 ||
+            GetDistance(triangulation.points[p1], triangulation.points[splitPoint]) < minEdgeLength ||
+            GetDistance(triangulation.points[splitPoint], triangulation.points[p2]) < minEdgeLength) {
+            return false;
+        }
+
+        segments.erase(SegmentKey(p1, p2));
+        AddSegment(p1, splitPoint);
+        AddSegment(splitPoint, p2);
+        return true;
+    }
+
+    // The cavity of an insertion has 2 triangles less than its border edges, unless there are points
+    // inside it. That only happens when the predicates can't tell the orientation of tiny triangles
+    bool RemovesPoints()
+    {
+        return bowyerWatson.badTriangles.size() + 2 != bowyerWatson.edges.size();
+    }
+
+    // True if the point is closer than minEdgeLength to the border of the cavity found for it
+    bool TooClose(const Vector3& point)
+    {
+        for (int i = 0; i < bowyerWatson.edges.size(); i++) {
+            if (GetDistance(triangulation.points[bowyerWatson.edges[i].p1], point) < minEdgeLength) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Walks from the node to point and returns the first segment crossed on the way (or (-1, -1))
+    // containingNode is set to the node containing point, or -1 if the walk doesn't get there
+    pair<int, int> FindCrossedSegment(int nodeId, Vector3 point, int& containingNode)
+    {
+        // Around tiny triangles the EPS tolerances can make the walk go in circles, so it is bounded
+        unsigned int seed = 1;
+        for (int steps = 0; nodeId != -1 && steps < triangulation.nodes.size(); steps++)
+        {
+            int edge = triangulation.WalkStep(nodeId, point, bowyerWatson.filtered, seed);
+            if (edge == -1) {
+                containingNode = nodeId;
+                return make_pair(-1, -1);
+            }
+
+            int e1 = triangulation.nodes[nodeId].points[(edge + 1) % 3];
+            int e2 = triangulation.nodes[nodeId].points[(edge + 2) % 3];
+            if (IsSegment(e1, e2)) {
+                return make_pair(e1, e2);
+            }
+            nodeId = triangulation.nodes[nodeId].neighbours[edge];
+        }
+
+        containingNode = -1;
+        return make_pair(-1, -1);
+    }
+
+    // Point to insert for the triangle, either the circumcenter or the off-center of its shortest edge
+    Vector3 SteinerPoint(int nodeId)
+    {
+        TriangulationNode& node = triangulation.nodes[nodeId];
+        Vector3 p1 = triangulation.points[node.points[0]];
+        Vector3 p2 = triangulation.points[node.points[1]];
+        Vector3 p3 = triangulation.points[node.points[2]];
+        Vector3 center = Circumcenter(p1, p2, p3);
+        if (!useOffCenters) {
+            return center;
+        }
+
+        // Find the shortest edge a-b
+        Vector3 a = p1, b = p2;
+        if (GetDistance(p2, p3) < GetDistance(a, b)) {
+            a = p2;
+            b = p3;
+        }
+        if (GetDistance(p3, p1) < GetDistance(a, b)) {
+            a = p3;
+            b = p1;
+        }
+
+        // The off-center is on the bisector of a-b, at the position where the triangle it makes with a-b
+        // has exactly the target radius-edge ratio
+        double length = GetDistance(a, b);
+        double radius = maxRatio * length;
+        double offDistance = sqrt(max(radius * radius - length * length / 4, 0.0)) + radius;
+
+        Vector3 middle = (a + b) * 0.5;
+        double centerDistance = GetDistance(middle, center);
+        if (centerDistance <= offDistance || centerDistance < EPS) {
+            return center;
+        }
+
+        return middle + (center - middle) * (offDistance / centerDistance);
+    }
+
+    // Inserts the steiner point of the triangle. If the point would encroach any segments, they are split
+    // instead and false is returned so the triangle can be checked again
+    bool FixTriangle(int nodeId)
+    {
+        Vector3 point = SteinerPoint(nodeId);
+        if (!bowyerWatson.kernel.Quantize(point)) {
+            return true;
+        }
+
+        // Points outside the hull are never inserted, the segment in the way gets split instead
+        int containingNode = -1;
+        pair<int, int> crossed = FindCrossedSegment(nodeId, point, containingNode);
+        if (crossed.first != -1) {
+            return !SplitSegment(crossed.first, crossed.second);
+        }
+
+        if (containingNode == -1) {
+            return true;
+        }
+
+        for (int x = 0; x < 3; x++) {
+            if (bowyerWatson.IsSuperPoint(triangulation.nodes[containingNode].points[x])) {
+                return true;
+            }
+        }
+
+        int pointId = triangulation.AddPoint(point);
+        bowyerWatson.ReserveWorkspace();
+        if (bowyerWatson.IsDuplicate(containingNode, pointId)) {
+            triangulation.points.pop_back();
+            return true;
+        }
+
+        // Don't insert the point if it encroaches a segment of its cavity, split the segments instead
+        vector<pair<int, int>> encroached;
+        if (!bowyerWatson.FindCavity(containingNode, pointId)) {
+            bowyerWatson.ClearCavity();
+            triangulation.points.pop_back();
+            return true;
+        }
+        for (int i = 0; i < bowyerWatson.badTriangles.size(); i++) {
+            TriangulationNode& node = triangulation.nodes[bowyerWatson.badTriangles[i]];
+            for (int x = 0; x < 3; x++) {
+                int e1 = node.points[(x + 1) % 3];
+                int e2 = node.points[(x + 2) % 3];
+                if (IsSegment(e1, e2) && Encroaches(e1, e2, point)) {
+                    encroached.push_back(make_pair(e1, e2));
+                }
+            }
+        }
+
+        // Give up on triangles that would need edges shorter than minEdgeLength
+        bool tooClose = RemovesPoints() || TooClose(point);
+
+        if (!encroached.empty() || tooClose) {
+            bowyerWatson.ClearCavity();
+            triangulation.points.pop_back();
+
+            bool split = false;
+            for (int i = 0; i < encroached.size(); i++) {
+                // The same segment can be seen from both its triangles
+                if (IsSegment(encroached[i].first, encroached[i].second)) {
+                    split |= SplitSegment(encroached[i].first, encroached[i].second);
+                }
+            }
+            return !split;
+        }
+
+        bowyerWatson.FillCavity(pointId);
+        CheckNewTriangles(pointId);
+        return true;
+    }
+};
+
+#endif
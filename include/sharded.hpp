@@ -0,0 +1,471 @@
+#ifndef __SHARDED__H
+#define __SHARDED__H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <unordered_set>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "constrained.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+// Triangulation split between worker processes
+// The bounding box of the points is cut in tilesX x tilesY tiles. Every worker gets the points of its tile
+// and of a margin around it (a shard), triangulates them and keeps the triangles it can prove are delaunay
+// for the whole pointset: the ones with the circumcircle inside the shard, since no point outside the shard
+// can be inside it. Each of those is kept by the tile containing its circumcenter only
+// The coordinator then stitches the seams: the area not covered by the proven triangles is bounded by their
+// edges and the convex hull, and it is triangulated again from the points around it
+// Shards and results go through binary files in workDir (the coordinates have to stay exact), a shard is all
+// a worker needs, so the workers can as well run on other machines sharing workDir
+//
+// Shard file:  owner box and shard box (8 doubles: minX minY maxX maxY), N, N point ids, N x y pairs (doubles)
+// Result file: T, then the 3 T (global) point ids of the counterclockwise triangles
+template <typename Kernel = DefaultKernel>
+class ShardedTriangulation {
+public:
+    Triangulation& triangulation;
+    Kernel kernel;
+    int tilesX;
+    int tilesY;
+
+    // Width of the margin around every tile, in average distances between the points
+    double marginSpacings;
+    string workDir;
+
+    ShardedTriangulation(Triangulation& _triangulation, int _tilesX, int _tilesY, double _marginSpacings = 10,
+                         string _workDir = "data/shards", Kernel _kernel = Kernel()) :
+        triangulation(_triangulation), kernel(_kernel), tilesX(_tilesX), tilesY(_tilesY),
+        marginSpacings(_marginSpacings), workDir(_workDir) {};
+
+    // Fills the triangulation, running "executable worker <shard> <result>" for every shard at the same time
+    // The default is the running binary itself, argv[0] isn't a path when it was found through PATH
+    // Returns false if a shard can't be written, a worker fails or the seams can't be stitched
+    bool Triangulate(const string& executable = "/proc/self/exe")
+    {
+        if (!WriteShards() || !RunWorkers(executable) || !ReadResults()) {
+            return false;
+        }
+
+        // The proven triangles are linked first, their edges without a neighbour are the border of the seams
+        LinkNodes();
+        if (!StitchSeams()) {
+            return false;
+        }
+
+        LinkNodes();
+
+        // No triangles at all is only right if the points are collinear
+        return !triangulation.nodes.empty() || triangulation.GetConvexHull().points.size() < 3;
+    }
+
+    // Worker side: triangulates a shard file and writes the proven triangles to the result file
+    static bool TriangulateShard(const string& shardFile, const string& resultFile, Kernel kernel = Kernel())
+    {
+        ifstream in(shardFile.c_str(), ios::binary);
+        double boxes[8];
+        int n = 0;
+        in.read((char*)boxes, sizeof(boxes));
+        in.read((char*)&n, sizeof(n));
+        if (!in || n < 0) {
+            return false;
+        }
+
+        vector<int> ids(n);
+        vector<double> coordinates(2 * n);
+        in.read((char*)ids.data(), n * sizeof(int));
+        in.read((char*)coordinates.data(), 2 * n * sizeof(double));
+        if (!in) {
+            return false;
+        }
+
+        vector<Vector3> points(n);
+        for (int i = 0; i < n; i++) {
+            points[i] = Vector3(coordinates[2 * i], coordinates[2 * i + 1], 0);
+        }
+        double* owner = boxes;
+        double* shard = boxes + 4;
+
+        // Empty shards (ex. tiles between clusters) have nothing to prove
+        // The super triangle is sized from the bounding box of the shard, its triangles are never proven so it
+        // isn't removed. Duplicates are left to the seams, a point that can't be inserted fails the shard
+        Triangulation triangulation = Triangulation(points);
+        if (n > 0) {
+            BowyerWatson<Kernel> bowyerWatson = BowyerWatson<Kernel>(triangulation, kernel);
+            bowyerWatson.GenerateSuperTriangle();
+            vector<int> order;
+            for (int i = 0; i < n; i++) {
+                order.push_back(i);
+            }
+            bowyerWatson.AddPointsAndRetriangulate(order);
+            if (!bowyerWatson.skippedPoints.empty()) {
+                return false;
+            }
+        }
+
+        vector<int> proven;
+        for (int i = 0; i < triangulation.nodes.size(); i++) {
+            TriangulationNode& node = triangulation.nodes[i];
+            if (node.points[0] >= n || node.points[1] >= n || node.points[2] >= n) {
+                continue;
+            }
+
+            Vector3& p1 = triangulation.points[node.points[0]];
+            Vector3& p2 = triangulation.points[node.points[1]];
+            Vector3& p3 = triangulation.points[node.points[2]];
+            if (kernel.Orient(p1, p2, p3) <= 0) {
+                continue;
+            }
+
+            // The circle has to stay strictly inside the shard, and the center in the owner box
+            Vector3 center = Circumcenter(p1, p2, p3);
+            double radius = GetDistance(center, p1) * (1 + 1e-9) + EPS;
+            bool inside = center.x - radius > shard[0] && center.y - radius > shard[1] &&
+                          center.x + radius < shard[2] && center.y + radius < shard[3];
+            bool owned = center.x >= owner[0] && center.y >= owner[1] && center.x < owner[2] && center.y < owner[3];
+
+            // Cocircular points can be triangulated several ways, and two shards might pick different ones
+            // (their circumcenters are rounded apart), so those triangles are left to the seams
+            for (int x = 0; x < 3 && inside && owned; x++) {
+                int neighbour = node.neighbours[x];
+                if (neighbour == -1) {
+                    continue;
+                }
+
+                TriangulationNode& other = triangulation.nodes[neighbour];
+                for (int y = 0; y < 3; y++) {
+                    int pointId = other.points[y];
+                    if (pointId != node.points[0] && pointId != node.points[1] && pointId != node.points[2] &&
+                        pointId < n && GetDistance(center, triangulation.points[pointId]) <= radius) {
+                        inside = false;
+                    }
+                }
+            }
+
+            if (inside && owned) {
+                for (int x = 0; x < 3; x++) {
+                    proven.push_back(ids[node.points[x]]);
+                }
+            }
+        }
+
+        ofstream out(resultFile.c_str(), ios::binary);
+        int cnt = proven.size() / 3;
+        out.write((char*)&cnt, sizeof(cnt));
+        out.write((char*)proven.data(), proven.size() * sizeof(int));
+
+        return (bool)out;
+    }
+
+private:
+    // Proven triangles from all the workers, then the seam triangles, 3 point ids each
+    vector<int> triangles;
+
+    static long long DirectedEdge(int p1, int p2)
+    {
+        return ((long long)p1 << 32) | (unsigned int)p2;
+    }
+
+    string ShardFile(int shard)
+    {
+        return workDir + "/shard_" + to_string(shard) + ".in";
+    }
+
+    string ResultFile(int shard)
+    {
+        return workDir + "/shard_" + to_string(shard) + ".out";
+    }
+
+    static int TileIndex(double value, double origin, double size, int tilesCnt)
+    {
+        if (size <= 0 || value < origin) {
+            return 0;
+        }
+
+        return min(tilesCnt - 1, (int)((value - origin) / size));
+    }
+
+    bool WriteShards()
+    {
+        vector<Vector3>& points = triangulation.points;
+        double minX = points[0].x, maxX = points[0].x;
+        double minY = points[0].y, maxY = points[0].y;
+        for (int i = 0; i < points.size(); i++) {
+            minX = min(minX, points[i].x);
+            maxX = max(maxX, points[i].x);
+            minY = min(minY, points[i].y);
+            maxY = max(maxY, points[i].y);
+        }
+
+        double tileW = (maxX - minX) / tilesX;
+        double tileH = (maxY - minY) / tilesY;
+        double margin = marginSpacings * sqrt((maxX - minX) * (maxY - minY) / points.size());
+
+        mkdir(workDir.c_str(), 0755);
+
+        // Tiles on the border own (and see) everything outside the bounding box, there are no points there
+        const double FAR = 1e300;
+        vector<vector<int>> shardPoints(tilesX * tilesY);
+        vector<vector<double>> shardBoxes(tilesX * tilesY);
+        for (int tx = 0; tx < tilesX; tx++) {
+            for (int ty = 0; ty < tilesY; ty++) {
+                double owner[4] = {
+                    tx == 0 ? -FAR : minX + tx * tileW, ty == 0 ? -FAR : minY + ty * tileH,
+                    tx == tilesX - 1 ? FAR : minX + (tx + 1) * tileW, ty == tilesY - 1 ? FAR : minY + (ty + 1) * tileH
+                };
+                double shard[4] = {
+                    tx == 0 ? -FAR : owner[0] - margin, ty == 0 ? -FAR : owner[1] - margin,
+                    tx == tilesX - 1 ? FAR : owner[2] + margin, ty == tilesY - 1 ? FAR : owner[3] + margin
+                };
+
+                int shardId = tx * tilesY + ty;
+                shardBoxes[shardId].assign(owner, owner + 4);
+                shardBoxes[shardId].insert(shardBoxes[shardId].end(), shard, shard + 4);
+            }
+        }
+
+        // Only the tiles closer than the margin can have the point in their shard
+        for (int i = 0; i < points.size(); i++) {
+            int firstX = TileIndex(points[i].x - margin, minX, tileW, tilesX);
+            int lastX = TileIndex(points[i].x + margin, minX, tileW, tilesX);
+            int firstY = TileIndex(points[i].y - margin, minY, tileH, tilesY);
+            int lastY = TileIndex(points[i].y + margin, minY, tileH, tilesY);
+            for (int x = firstX; x <= lastX; x++) {
+                for (int y = firstY; y <= lastY; y++) {
+                    vector<double>& box = shardBoxes[x * tilesY + y];
+                    if (points[i].x >= box[4] && points[i].y >= box[5] && points[i].x <= box[6] && points[i].y <= box[7]) {
+                        shardPoints[x * tilesY + y].push_back(i);
+                    }
+                }
+            }
+        }
+
+        for (int shard = 0; shard < tilesX * tilesY; shard++) {
+            vector<int>& ids = shardPoints[shard];
+            vector<double> coordinates;
+            for (int i = 0; i < ids.size(); i++) {
+                coordinates.push_back(points[ids[i]].x);
+                coordinates.push_back(points[ids[i]].y);
+            }
+
+            int n = ids.size();
+            ofstream out(ShardFile(shard).c_str(), ios::binary);
+            out.write((char*)shardBoxes[shard].data(), 8 * sizeof(double));
+            out.write((char*)&n, sizeof(n));
+            out.write((char*)ids.data(), n * sizeof(int));
+            out.write((char*)coordinates.data(), 2 * n * sizeof(double));
+            if (!out) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool RunWorkers(const string& executable)
+    {
+        vector<pid_t> workers;
+        for (int shard = 0; shard < tilesX * tilesY; shard++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                execl(executable.c_str(), executable.c_str(), "worker", ShardFile(shard).c_str(),
+                      ResultFile(shard).c_str(), (char*)NULL);
+                _exit(127);
+            }
+            workers.push_back(pid);
+        }
+
+        bool ok = true;
+        for (int i = 0; i < workers.size(); i++) {
+            int status;
+            if (workers[i] < 0 || waitpid(workers[i], &status, 0) != workers[i] ||
+                !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                ok = false;
+            }
+        }
+
+        return ok;
+    }
+
+    bool ReadResults()
+    {
+        triangles.clear();
+        for (int shard = 0; shard < tilesX * tilesY; shard++) {
+            ifstream in(ResultFile(shard).c_str(), ios::binary);
+            int cnt = 0;
+            in.read((char*)&cnt, sizeof(cnt));
+            if (!in || cnt < 0) {
+                return false;
+            }
+
+            int begin = triangles.size();
+            triangles.resize(begin + 3 * cnt);
+            in.read((char*)(triangles.data() + begin), 3 * cnt * sizeof(int));
+            if (!in) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Triangulates the area not covered by the proven triangles. Its points are the ones not used by any proven
+    // triangle and the ones on the border of the proven area. The delaunay triangles over there have empty circles,
+    // so they are delaunay for these points as well, the ones on this side of the border are the missing triangles
+    bool StitchSeams()
+    {
+        vector<Vector3>& points = triangulation.points;
+        vector<TriangulationNode>& provenNodes = triangulation.nodes;
+        vector<char> used(points.size(), false);
+
+        // Border of the proven area, with the proven triangle on the left
+        vector<pair<int, int>> border;
+        unordered_set<long long> borderEdges;
+        for (int i = 0; i < provenNodes.size(); i++) {
+            for (int x = 0; x < 3; x++) {
+                used[provenNodes[i].points[x]] = true;
+                if (provenNodes[i].neighbours[x] == -1) {
+                    int p1 = provenNodes[i].points[(x + 1) % 3];
+                    int p2 = provenNodes[i].points[(x + 2) % 3];
+                    border.push_back(make_pair(p1, p2));
+                    borderEdges.insert(DirectedEdge(p1, p2));
+                }
+            }
+        }
+
+        // The border points go first, so the duplicates of a border point are the ones left out
+        vector<int> seamIds(points.size(), -1);
+        vector<int> seamPoints;
+        for (int i = 0; i < border.size(); i++) {
+            int ends[2] = { border[i].first, border[i].second };
+            for (int k = 0; k < 2; k++) {
+                if (seamIds[ends[k]] == -1) {
+                    seamIds[ends[k]] = seamPoints.size();
+                    seamPoints.push_back(ends[k]);
+                }
+            }
+        }
+        for (int i = 0; i < points.size(); i++) {
+            if (!used[i]) {
+                seamIds[i] = seamPoints.size();
+                seamPoints.push_back(i);
+            }
+        }
+
+        if (seamPoints.empty()) {
+            return true;
+        }
+
+        vector<Vector3> seamPositions;
+        for (int i = 0; i < seamPoints.size(); i++) {
+            seamPositions.push_back(points[seamPoints[i]]);
+        }
+
+        // The hull points are never in a proven triangle without being on the border, so the hull of the seam
+        // is the hull of all the points
+        Triangulation seam = Triangulation(seamPositions);
+        BowyerWatson<Kernel> bowyerWatson = BowyerWatson<Kernel>(seam, kernel);
+        bowyerWatson.GenerateSuperTriangle();
+        vector<int> order;
+        for (int i = 0; i < seamPoints.size(); i++) {
+            order.push_back(i);
+        }
+        bowyerWatson.AddPointsAndRetriangulate(order);
+        if (!bowyerWatson.skippedPoints.empty()) {
+            return false;
+        }
+        bowyerWatson.RemoveSuperTriangle();
+
+        // The border edges are delaunay edges, so they are already there unless some points are cocircular
+        // The walks along them need the filtered predicates, the tolerances see a point slightly off the
+        // segment as on it and can go back and forth between two points
+        ConstrainedDelaunay<FilteredKernel<Kernel>> constrained(seam, bowyerWatson.filtered);
+        for (int i = 0; i < border.size(); i++) {
+            if (!constrained.InsertConstraint(seamIds[border[i].first], seamIds[border[i].second])) {
+                return false;
+            }
+        }
+
+        // The border splits the seam triangulation in parts. The parts having a border edge the same way around
+        // are inside the proven area, the others are missing
+        vector<TriangulationNode>& nodes = seam.nodes;
+        vector<int> part(nodes.size(), -1);
+        for (int start = 0; start < nodes.size(); start++) {
+            if (part[start] != -1) {
+                continue;
+            }
+
+            vector<int> members(1, start);
+            part[start] = start;
+            bool missing = true;
+            for (int k = 0; k < members.size(); k++) {
+                TriangulationNode& node = nodes[members[k]];
+                for (int x = 0; x < 3; x++) {
+                    int p1 = node.points[(x + 1) % 3];
+                    int p2 = node.points[(x + 2) % 3];
+                    if (borderEdges.count(DirectedEdge(seamPoints[p1], seamPoints[p2]))) {
+                        missing = false;
+                    }
+
+                    int neighbour = node.neighbours[x];
+                    if (neighbour != -1 && part[neighbour] == -1 && !seam.IsConstrained(p1, p2)) {
+                        part[neighbour] = start;
+                        members.push_back(neighbour);
+                    }
+                }
+            }
+
+            for (int k = 0; missing && k < members.size(); k++) {
+                for (int x = 0; x < 3; x++) {
+                    triangles.push_back(seamPoints[nodes[members[k]].points[x]]);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Builds the nodes from the triangles, neighbours[x] being the triangle across the edge opposite to points[x]
+    // The edges are sorted instead of hashed, the two sides of an edge end up next to each other
+    void LinkNodes()
+    {
+        vector<pair<long long, int>> edges;
+        edges.reserve(triangles.size());
+        for (int i = 0; i < triangles.size(); i += 3) {
+            for (int x = 0; x < 3; x++) {
+                edges.push_back(make_pair(Triangulation::EdgeKey(triangles[i + (x + 1) % 3], triangles[i + (x + 2) % 3]), i + x));
+            }
+        }
+        ParallelSort(edges, [](const pair<long long, int>& lhs, const pair<long long, int>& rhs) {
+            return lhs < rhs;
+        });
+
+        triangulation.nodes.clear();
+        for (int i = 0; i < triangles.size(); i += 3) {
+            int nodeId = triangulation.AddNode(TriangulationNode());
+            triangulation.EditNode(nodeId, triangles[i], triangles[i + 1], triangles[i + 2], -1, -1, -1);
+        }
+
+        for (int i = 0; i + 1 < edges.size(); i++) {
+            if (edges[i].first == edges[i + 1].first) {
+                int first = edges[i].second;
+                int second = edges[i + 1].second;
+                triangulation.nodes[first / 3].neighbours[first % 3] = second / 3;
+                triangulation.nodes[second / 3].neighbours[second % 3] = first / 3;
+                i++;
+            }
+        }
+    }
+};
+
+#endif
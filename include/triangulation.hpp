@@ -3,8 +3,14 @@
 
 #include <vector>
 #include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_set>
 
 #include "common.hpp"
+#include "kernel.hpp"
+#include "convexhull.hpp"
 
 using namespace std;
 
@@ -30,11 +36,54 @@ public:
     vector<Vector3> points;
     vector<TriangulationNode> nodes;
 
-    Triangulation() {};
-    Triangulation(vector<Vector3> _points) : points(_points) {};
+    Triangulation() : convexHullValid(false) {};
+    Triangulation(vector<Vector3> _points) : points(_points), convexHullValid(false) {};
+
+    // Returns the convex hull of the points, it is only computed again after points are added or removed
+    // Note points edited in place are not tracked, call InvalidateConvexHull after doing that
+    const ConvexHull& GetConvexHull()
+    {
+        if (!convexHullValid) {
+            convexHull.Compute(points);
+            convexHullValid = true;
+        }
+
+        return convexHull;
+    }
+
+    void InvalidateConvexHull()
+    {
+        convexHullValid = false;
+    }
+
+    // Edges that have to stay in the triangulation (ex. obstacles of a navmesh), see constrained.hpp
+    // Note only the constrained triangulation and the flip algorithm know about them
+    static long long EdgeKey(int p1, int p2)
+    {
+        if (p1 > p2) {
+            swap(p1, p2);
+        }
+
+        return ((long long)p1 << 32) | p2;
+    }
+
+    bool IsConstrained(int p1, int p2)
+    {
+        return !constrainedEdges.empty() && constrainedEdges.count(EdgeKey(p1, p2)) > 0;
+    }
+
+    void SetConstrained(int p1, int p2, bool constrained)
+    {
+        if (constrained) {
+            constrainedEdges.insert(EdgeKey(p1, p2));
+        } else {
+            constrainedEdges.erase(EdgeKey(p1, p2));
+        }
+    }
 
     // Adds a new point to the pointset and returns it's id
     int AddPoint(Vector3 point) {
+        convexHullValid = false;
         points.push_back(point);
         return points.size() - 1;
     }
@@ -51,11 +100,13 @@ public:
     // Note this will invalidate any external stored pointIds
     void RemovePoint(int pointId)
     {
+        convexHullValid = false;
+
         // Remove point
         vector<int> pointNewIds;
         pointNewIds.resize(points.size());
         int crtPos = 0;       
-        for (int i = 0; i < points.size() - 1; i++) {
+        for (int i = 0; i < points.size(); i++) {
             if (i == pointId) {
                 pointNewIds[i] = -1;
                 continue;
@@ -108,6 +159,42 @@ public:
                 nodes[i].neighbours[2] = nodeNewIds[nodes[i].neighbours[2]];
             }
         }
+
+        // The constrained edges are stored by point ids as well
+        unordered_set<long long> oldConstrainedEdges;
+        oldConstrainedEdges.swap(constrainedEdges);
+        for (unordered_set<long long>::iterator it = oldConstrainedEdges.begin(); it != oldConstrainedEdges.end(); it++) {
+            int p1 = pointNewIds[*it >> 32];
+            int p2 = pointNewIds[*it & 0xFFFFFFFFLL];
+            if (p1 != -1 && p2 != -1) {
+                constrainedEdges.insert(EdgeKey(p1, p2));
+            }
+        }
+    }
+
+    // Removes a node no other node links to. The last node is moved in its place and its id is returned
+    // Note this will invalidate any external stored id of the last node
+    int RemoveUnusedNode(int nodeId)
+    {
+        int lastId = nodes.size() - 1;
+        if (nodeId != lastId) {
+            nodes[nodeId] = nodes[lastId];
+            for (int x = 0; x < 3; x++) {
+                int neighbour = nodes[nodeId].neighbours[x];
+                if (neighbour == -1) {
+                    continue;
+                }
+
+                for (int y = 0; y < 3; y++) {
+                    if (nodes[neighbour].neighbours[y] == lastId) {
+                        nodes[neighbour].neighbours[y] = nodeId;
+                    }
+                }
+            }
+        }
+
+        nodes.pop_back();
+        return lastId;
     }
 
     // Splits one triangle into three triangles given a point inside the triangle
@@ -183,7 +270,7 @@ public:
             if (nodes[node2].points[x] != p4 &&
                 nodes[node2].points[x] != p5) {
                 p6 = nodes[node2].points[x];
-                t6 = nodes[node1].neighbours[x];
+                t6 = nodes[node2].neighbours[x];
             }
         }
 
@@ -246,7 +333,7 @@ public:
     {
         cout << points.size() << " " << nodes.size() << endl;
         for (int i = 0; i < points.size(); i++) {
-            cout << points[i].x << " " << points[i].y << " " << points[i].z << endl;
+            cout << Format(points[i].x) << " " << Format(points[i].y) << " " << Format(points[i].z) << endl;
         }
 
         for (int i = 0; i < nodes.size(); i++) {
@@ -261,6 +348,41 @@ public:
         }
     }
 
+    // Shortest of 15 or 17 significant digits that reads back as the same double, so Read (and the verifier)
+    // see the points the triangulation was built on, even for big coordinates
+    static string Format(double value)
+    {
+        char buff[32];
+        snprintf(buff, sizeof(buff), "%.15g", value);
+        if (strtod(buff, NULL) != value) {
+            snprintf(buff, sizeof(buff), "%.17g", value);
+        }
+
+        return buff;
+    }
+
+    // Reads a triangulation in the format written by Print
+    void Read()
+    {
+        int pointsCnt, nodesCnt;
+        cin >> pointsCnt >> nodesCnt;
+        points.resize(pointsCnt);
+        for (int i = 0; i < pointsCnt; i++) {
+            cin >> points[i].x >> points[i].y >> points[i].z;
+        }
+
+        nodes.clear();
+        for (int i = 0; i < nodesCnt; i++) {
+            TriangulationNode node;
+            cin >> node.points[0] >> node.points[1] >> node.points[2];
+            cin >> node.neighbours[0] >> node.neighbours[1] >> node.neighbours[2];
+            AddNode(node);
+        }
+
+        convexHullValid = false;
+        constrainedEdges.clear();
+    }
+
     void EditNode(int nodeID, int p1, int p2, int p3, int t1, int t2, int t3) {
         nodes[nodeID].points[0] = p1;
         nodes[nodeID].points[1] = p2;
@@ -271,34 +393,60 @@ public:
         nodes[nodeID].neighbours[2] = t3;
     }
 
-    int JumpAndWalk(Vector3 point)
+    // Returns the index of an edge of the node that has the point on its other side, or -1 if the node
+    // contains the point. The first edge checked is picked at random, so walks made of these steps
+    // can't loop forever even when rounding errors leave the triangulation slightly non delaunay
+    template <typename Kernel>
+    int WalkStep(int nodeId, Vector3 point, const Kernel& kernel, unsigned int& seed)
     {
-        // TODO: start with a rando node
-        int nodeId = 0;
-
-        while (!nodes[nodeId].ContainsPoint(point))
-        {
-            Vector3 p1 = points[nodes[nodeId].points[0]];
-            Vector3 p2 = points[nodes[nodeId].points[1]];
-            Vector3 p3 = points[nodes[nodeId].points[2]];                       
-
-            Vector3 triangleCenter = p1 * (1.0 / 3) + p2 * (1.0 / 3) + p3 * (1.0 / 3);
-            for (int i = 0; i < 3; i++) {
-                Vector3 p1 = points[nodes[nodeId].points[(i + 1) % 3]];
-                Vector3 p2 = points[nodes[nodeId].points[(i + 2) % 3]];
-                if (SegmentIntersect(triangleCenter, point, p1, p2)) {
-                    nodeId = nodes[nodeId].neighbours[i];
-                    break;
-                }
+        Vector3& p1 = points[nodes[nodeId].points[0]];
+        Vector3& p2 = points[nodes[nodeId].points[1]];
+        Vector3& p3 = points[nodes[nodeId].points[2]];
+        int orientation = kernel.Orient(p1, p2, p3) < 0 ? -1 : 1;
+
+        seed = seed * 1103515245 + 12345;
+        int first = (seed >> 16) % 3;
+        for (int k = 0; k < 3; k++) {
+            int i = (first + k) % 3;
+            Vector3& e1 = points[nodes[nodeId].points[(i + 1) % 3]];
+            Vector3& e2 = points[nodes[nodeId].points[(i + 2) % 3]];
+            if (kernel.Orient(e1, e2, point) == -orientation) {
+                return i;
             }
+        }
+
+        return -1;
+    }
 
-            if (nodeId == -1) {
-                return -1;
+    // Walks from startNode towards point and returns the node containing it (-1 if outside)
+    template <typename Kernel>
+    int JumpAndWalk(Vector3 point, int startNode, const Kernel& kernel)
+    {
+        int nodeId = startNode;
+        unsigned int seed = 1;
+
+        while (nodeId != -1)
+        {
+            int edge = WalkStep(nodeId, point, kernel, seed);
+            if (edge == -1) {
+                return nodeId;
             }
+            nodeId = nodes[nodeId].neighbours[edge];
         }
 
-        return nodeId;
+        return -1;
     }
+
+    int JumpAndWalk(Vector3 point, int startNode = 0)
+    {
+        return JumpAndWalk(point, startNode, DoubleKernel());
+    }
+
+private:
+    ConvexHull convexHull;
+    bool convexHullValid;
+
+    unordered_set<long long> constrainedEdges;
 };
 
 // TODO: Move this to a proper cpp file
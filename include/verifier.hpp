@@ -0,0 +1,252 @@
+#ifndef __VERIFIER__H
+#define __VERIFIER__H
+
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+enum ViolationType {
+    // A point or neighbour id out of range, or a triangle using the same point twice
+    INVALID_INDEX,
+    // The neighbour across an edge doesn't have the edge, or doesn't point back
+    ASYMMETRIC_NEIGHBOUR,
+    // Flat triangle, or clockwise triangle when every triangle has to be counterclockwise
+    WRONG_ORIENTATION,
+    // The edges without a neighbour don't form one closed loop
+    OPEN_HULL,
+    // The loop of edges without a neighbour turns right, so the triangles don't cover the convex hull
+    CONCAVE_HULL,
+    // The point across the (unconstrained) edge is inside the circumcircle of the triangle
+    NOT_DELAUNAY,
+    VIOLATION_TYPES
+};
+
+const char* VIOLATION_NAMES[VIOLATION_TYPES] = {
+    "invalid_index", "asymmetric_neighbour", "wrong_orientation", "open_hull", "concave_hull", "not_delaunay"
+};
+
+// A problem found on the edge opposite to points[edge] of the node (edge is -1 for the whole triangle)
+struct Violation {
+    ViolationType type;
+    int nodeId;
+    int edge;
+};
+
+// Result of TriangulationVerifier::Verify. Every violation is counted, only the first ones are listed
+class VerificationReport {
+public:
+    long long counts[VIOLATION_TYPES];
+    vector<Violation> violations;
+
+    int nodesCnt;
+    int hullEdgesCnt;
+
+    VerificationReport() : nodesCnt(0), hullEdgesCnt(0)
+    {
+        for (int i = 0; i < VIOLATION_TYPES; i++) {
+            counts[i] = 0;
+        }
+    };
+
+    bool IsValid() const
+    {
+        for (int i = 0; i < VIOLATION_TYPES; i++) {
+            if (counts[i] > 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // One "name count" line per violation type, then one "name node edge" line per listed violation
+    void Print(ostream& out) const
+    {
+        out << (IsValid() ? "valid" : "invalid") << " nodes " << nodesCnt << " hull_edges " << hullEdgesCnt << endl;
+        for (int i = 0; i < VIOLATION_TYPES; i++) {
+            out << VIOLATION_NAMES[i] << " " << counts[i] << endl;
+        }
+
+        for (int i = 0; i < violations.size(); i++) {
+            out << VIOLATION_NAMES[violations[i].type] << " " << violations[i].nodeId << " " << violations[i].edge << endl;
+        }
+    }
+};
+
+// Checks a triangulation in O(T): neighbour symmetry, orientation, the hull and the empty circle property
+// of every edge. The nodes are split between the threads, every thread reports on its own block
+// and the reports are merged in order, so the result doesn't depend on the number of threads
+// The checks use the filtered predicates (see FilteredKernel): the EPS tolerances of the double kernel would call
+// small valid triangles flat and miss the points barely inside small circumcircles
+// Note the flip algorithm doesn't orient its triangles, verify its output with counterclockwise = false
+template <typename Kernel = DefaultKernel>
+class TriangulationVerifier {
+public:
+    Kernel kernel;
+    FilteredKernel<Kernel> filtered;
+    bool counterclockwise;
+
+    // How many violations are listed in the report (all of them are counted)
+    int maxReported;
+
+    TriangulationVerifier(Kernel _kernel = Kernel(), bool _counterclockwise = true, int _maxReported = 100) :
+        kernel(_kernel), filtered(_kernel), counterclockwise(_counterclockwise), maxReported(_maxReported) {};
+
+    VerificationReport Verify(Triangulation& triangulation)
+    {
+        vector<VerificationReport> reports(ThreadsCount());
+        vector<vector<HullEdge>> hullEdges(ThreadsCount());
+        ParallelFor(triangulation.nodes.size(), [&](int t, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                VerifyNode(triangulation, i, reports[t], hullEdges[t]);
+            }
+        });
+
+        VerificationReport report;
+        report.nodesCnt = triangulation.nodes.size();
+        vector<HullEdge> hull;
+        for (int t = 0; t < reports.size(); t++) {
+            for (int i = 0; i < VIOLATION_TYPES; i++) {
+                report.counts[i] += reports[t].counts[i];
+            }
+            for (int i = 0; i < reports[t].violations.size(); i++) {
+                AddViolation(report, reports[t].violations[i]);
+            }
+            hull.insert(hull.end(), hullEdges[t].begin(), hullEdges[t].end());
+        }
+
+        VerifyHull(triangulation, hull, report);
+        return report;
+    }
+
+private:
+    // Edge without a neighbour, from -> to with the triangle on its left
+    struct HullEdge {
+        int from;
+        int to;
+        int nodeId;
+        int edge;
+    };
+
+    void AddViolation(VerificationReport& report, Violation violation)
+    {
+        if (report.violations.size() < maxReported) {
+            report.violations.push_back(violation);
+        }
+    }
+
+    void Report(VerificationReport& report, ViolationType type, int nodeId, int edge)
+    {
+        report.counts[type]++;
+        Violation violation = { type, nodeId, edge };
+        AddViolation(report, violation);
+    }
+
+    void VerifyNode(Triangulation& triangulation, int nodeId, VerificationReport& report, vector<HullEdge>& hull)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        TriangulationNode& node = nodes[nodeId];
+
+        for (int x = 0; x < 3; x++) {
+            int neighbour = node.neighbours[x];
+            if (node.points[x] < 0 || node.points[x] >= points.size() || node.points[x] == node.points[(x + 1) % 3] ||
+                neighbour < -1 || neighbour >= (int)nodes.size() || neighbour == nodeId) {
+                Report(report, INVALID_INDEX, nodeId, -1);
+                return;
+            }
+        }
+
+        int orientation = filtered.Orient(points[node.points[0]], points[node.points[1]], points[node.points[2]]);
+        if (orientation == 0 || (counterclockwise && orientation < 0)) {
+            Report(report, WRONG_ORIENTATION, nodeId, -1);
+        }
+
+        for (int x = 0; x < 3; x++) {
+            int q = node.points[(x + 1) % 3];
+            int r = node.points[(x + 2) % 3];
+            int neighbour = node.neighbours[x];
+            if (neighbour == -1) {
+                HullEdge edge = { orientation < 0 ? r : q, orientation < 0 ? q : r, nodeId, x };
+                hull.push_back(edge);
+                continue;
+            }
+
+            // The neighbour has to share q-r, and its edge q-r has to lead back here
+            TriangulationNode& other = nodes[neighbour];
+            int s = -1;
+            int shared = 0;
+            for (int y = 0; y < 3; y++) {
+                if (other.points[y] == q || other.points[y] == r) {
+                    shared++;
+                } else {
+                    s = y;
+                }
+            }
+
+            if (shared != 2 || s == -1 || other.neighbours[s] != nodeId) {
+                Report(report, ASYMMETRIC_NEIGHBOUR, nodeId, x);
+                continue;
+            }
+
+            // Every edge is checked once, from the node with the smaller id
+            if (nodeId < neighbour && other.points[s] >= 0 && other.points[s] < points.size() &&
+                !triangulation.IsConstrained(q, r) &&
+                filtered.InCircle(points[node.points[0]], points[node.points[1]], points[node.points[2]],
+                                  points[other.points[s]])) {
+                Report(report, NOT_DELAUNAY, nodeId, x);
+            }
+        }
+    }
+
+    // The hull edges have to chain into one loop without turning right
+    void VerifyHull(Triangulation& triangulation, const vector<HullEdge>& hull, VerificationReport& report)
+    {
+        report.hullEdgesCnt = hull.size();
+        if (hull.empty()) {
+            return;
+        }
+
+        unordered_map<int, int> next;
+        for (int i = 0; i < hull.size(); i++) {
+            if (next.count(hull[i].from)) {
+                Report(report, OPEN_HULL, hull[i].nodeId, hull[i].edge);
+            } else {
+                next[hull[i].from] = i;
+            }
+        }
+
+        vector<Vector3>& points = triangulation.points;
+        int loopSize = 0;
+        int crt = 0;
+        do {
+            unordered_map<int, int>::iterator following = next.find(hull[crt].to);
+            if (following == next.end()) {
+                Report(report, OPEN_HULL, hull[crt].nodeId, hull[crt].edge);
+                return;
+            }
+
+            int nextEdge = following->second;
+            if (filtered.Orient(points[hull[crt].from], points[hull[crt].to], points[hull[nextEdge].to]) < 0) {
+                Report(report, CONCAVE_HULL, hull[nextEdge].nodeId, hull[nextEdge].edge);
+            }
+
+            crt = nextEdge;
+            loopSize++;
+        } while (crt != 0 && loopSize <= hull.size());
+
+        // Holes or several components
+        if (loopSize != next.size()) {
+            Report(report, OPEN_HULL, hull[0].nodeId, hull[0].edge);
+        }
+    }
+};
+
+#endif
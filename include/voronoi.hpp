@@ -0,0 +1,240 @@
+#ifndef __VORONOI__H
+#define __VORONOI__H
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "common.hpp"
+#include "triangulation.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+// Voronoi diagram (the dual of a triangulation) with every cell clipped to a bounding box
+// Cells are stored back to back: the cell of point i is the polygon
+// cellVertices[cellStart[i]], ..., cellVertices[cellStart[i + 1] - 1] in counterclockwise order
+class VoronoiDiagram {
+public:
+    vector<int> cellStart;
+    vector<Vector3> cellVertices;
+
+    // Circumcenter of every node of the triangulation (the voronoi vertices before clipping)
+    vector<Vector3> circumcenters;
+
+    // Points with an empty cell because the triangles around them don't link up into a star
+    // (ex. neighbours that don't point back), so walking around the point never ends
+    vector<int> brokenCells;
+
+    // Builds the diagram for the given triangulation, clipping the cells to [boxMin, boxMax]
+    // Note this assumes the nodes are in counterclockwise order
+    void Build(Triangulation& triangulation, Vector3 boxMin, Vector3 boxMax)
+    {
+        vector<Vector3>& points = triangulation.points;
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+
+        // Independent for every node so just split them between threads
+        // Also one node using each point, to start walking the star of the point from. Any node will do, so the
+        // threads just race to write it
+        circumcenters.resize(nodes.size());
+        vector<int> pointNode(points.size(), -1);
+        ParallelFor(nodes.size(), [this, &points, &nodes, &pointNode](int t, int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                circumcenters[i] = Circumcenter(points[nodes[i].points[0]],
+                                                points[nodes[i].points[1]],
+                                                points[nodes[i].points[2]]);
+                for (int x = 0; x < 3; x++) {
+                    __atomic_store_n(&pointNode[nodes[i].points[x]], i, __ATOMIC_RELAXED);
+                }
+            }
+        });
+
+        // Every thread builds the cells of a block of points, the blocks are glued together at the end
+        int threadsCnt = ThreadsCount();
+        vector<vector<int>> blockCellSizes(threadsCnt);
+        vector<vector<Vector3>> blockVertices(threadsCnt);
+        vector<vector<int>> blockBroken(threadsCnt);
+        ParallelFor(points.size(), [&](int t, int begin, int end) {
+            vector<Vector3> cell, clipped;
+            for (int i = begin; i < end; i++) {
+                if (!BuildCell(triangulation, i, pointNode[i], boxMin, boxMax, cell, clipped)) {
+                    blockBroken[t].push_back(i);
+                }
+                blockCellSizes[t].push_back(cell.size());
+                blockVertices[t].insert(blockVertices[t].end(), cell.begin(), cell.end());
+            }
+        });
+
+        cellStart.clear();
+        cellStart.push_back(0);
+        cellVertices.clear();
+        brokenCells.clear();
+        for (int t = 0; t < threadsCnt; t++) {
+            for (int i = 0; i < blockCellSizes[t].size(); i++) {
+                cellStart.push_back(cellStart.back() + blockCellSizes[t][i]);
+            }
+            cellVertices.insert(cellVertices.end(), blockVertices[t].begin(), blockVertices[t].end());
+            brokenCells.insert(brokenCells.end(), blockBroken[t].begin(), blockBroken[t].end());
+        }
+    }
+
+    // Same as above, with the bounding box of the points grown by margin on every side
+    void Build(Triangulation& triangulation, double margin)
+    {
+        vector<Vector3>& points = triangulation.points;
+        if (points.empty()) {
+            cellStart.assign(1, 0);
+            cellVertices.clear();
+            return;
+        }
+
+        Vector3 boxMin = points[0], boxMax = points[0];
+        for (int i = 0; i < points.size(); i++) {
+            boxMin = Vector3(min(boxMin.x, points[i].x), min(boxMin.y, points[i].y), 0);
+            boxMax = Vector3(max(boxMax.x, points[i].x), max(boxMax.y, points[i].y), 0);
+        }
+
+        Build(triangulation, boxMin + Vector3(-margin, -margin, 0), boxMax + Vector3(margin, margin, 0));
+    }
+
+    void Print()
+    {
+        cout << cellStart.size() - 1 << " " << cellVertices.size() << endl;
+        for (int i = 0; i < cellStart.size(); i++) {
+            cout << cellStart[i] << " ";
+        }
+        cout << endl;
+
+        for (int i = 0; i < cellVertices.size(); i++) {
+            cout << Triangulation::Format(cellVertices[i].x) << " " << Triangulation::Format(cellVertices[i].y) << " "
+                 << Triangulation::Format(cellVertices[i].z) << endl;
+        }
+    }
+
+private:
+    // Walks the triangles around pointId and writes its clipped cell to cell
+    // Returns false, with an empty cell, if the walk takes more steps than there are nodes (the star is broken)
+    bool BuildCell(Triangulation& triangulation, int pointId, int startNode, Vector3 boxMin, Vector3 boxMax,
+                   vector<Vector3>& cell, vector<Vector3>& clipped)
+    {
+        vector<TriangulationNode>& nodes = triangulation.nodes;
+        vector<Vector3>& points = triangulation.points;
+        int maxSteps = nodes.size();
+        cell.clear();
+
+        // Point not used by any triangle (ex. a duplicated point)
+        if (startNode == -1) {
+            return true;
+        }
+
+        // Go counterclockwise around the point until we are back at the start or reach the hull
+        int nodeId = startNode;
+        do {
+            if (cell.size() == maxSteps) {
+                cell.clear();
+                return false;
+            }
+            cell.push_back(circumcenters[nodeId]);
+            nodeId = nodes[nodeId].neighbours[(LocalIndex(nodes[nodeId], pointId) + 1) % 3];
+        } while (nodeId != -1 && nodeId != startNode);
+
+        if (nodeId == -1) {
+            // The point is on the hull, so first go clockwise to find the other end of the star
+            int firstNode = startNode;
+            int prevNode = nodes[startNode].neighbours[(LocalIndex(nodes[startNode], pointId) + 2) % 3];
+            for (int steps = 0; prevNode != -1; steps++) {
+                if (steps == maxSteps) {
+                    cell.clear();
+                    return false;
+                }
+                firstNode = prevNode;
+                prevNode = nodes[prevNode].neighbours[(LocalIndex(nodes[prevNode], pointId) + 2) % 3];
+            }
+
+            cell.clear();
+            int lastNode = firstNode;
+            for (nodeId = firstNode; nodeId != -1;
+                 nodeId = nodes[nodeId].neighbours[(LocalIndex(nodes[nodeId], pointId) + 1) % 3]) {
+                if (cell.size() == maxSteps) {
+                    cell.clear();
+                    return false;
+                }
+                cell.push_back(circumcenters[nodeId]);
+                lastNode = nodeId;
+            }
+
+            // The cell is unbounded, close it with points far along the rays perpendicular to the two hull edges
+            double far = 2 * (GetDistance(boxMin, boxMax) + GetDistance(points[pointId], boxMin) +
+                              GetDistance(cell[0], points[pointId]) + GetDistance(cell.back(), points[pointId]));
+
+            int x = LocalIndex(nodes[lastNode], pointId);
+            Vector3 hullPoint = points[nodes[lastNode].points[(x + 2) % 3]];
+            cell.push_back(cell.back() + OutwardNormal(hullPoint, points[pointId]) * far);
+
+            x = LocalIndex(nodes[firstNode], pointId);
+            hullPoint = points[nodes[firstNode].points[(x + 1) % 3]];
+            cell.push_back(cell[0] + OutwardNormal(points[pointId], hullPoint) * far);
+        }
+
+        // Sutherland-Hodgman clipping against the sides of the box the cell crosses, most cells are inside it
+        Vector3 cellMin = cell[0], cellMax = cell[0];
+        for (int i = 1; i < cell.size(); i++) {
+            cellMin = Vector3(min(cellMin.x, cell[i].x), min(cellMin.y, cell[i].y), 0);
+            cellMax = Vector3(max(cellMax.x, cell[i].x), max(cellMax.y, cell[i].y), 0);
+        }
+
+        for (int side = 0; side < 4; side++) {
+            if (SideDistance(side % 2 == 0 ? cellMin : cellMax, side, boxMin, boxMax) >= 0) {
+                continue;
+            }
+
+            clipped.clear();
+            for (int i = 0; i < cell.size(); i++) {
+                Vector3 p1 = cell[i];
+                Vector3 p2 = cell[(i + 1) % cell.size()];
+                double d1 = SideDistance(p1, side, boxMin, boxMax);
+                double d2 = SideDistance(p2, side, boxMin, boxMax);
+
+                if (d1 >= 0) {
+                    clipped.push_back(p1);
+                }
+                if ((d1 >= 0) != (d2 >= 0)) {
+                    clipped.push_back(p1 + (p2 - p1) * (d1 / (d1 - d2)));
+                }
+            }
+            cell.swap(clipped);
+        }
+
+        return true;
+    }
+
+    // Index of pointId in the node
+    static int LocalIndex(TriangulationNode& node, int pointId)
+    {
+        if (node.points[0] == pointId) {
+            return 0;
+        }
+
+        return node.points[1] == pointId ? 1 : 2;
+    }
+
+    // Unit normal of the counterclockwise hull edge p1 -> p2, pointing outside the hull
+    static Vector3 OutwardNormal(Vector3 p1, Vector3 p2)
+    {
+        double length = GetDistance(p1, p2);
+        return Vector3((p2.y - p1.y) / length, (p1.x - p2.x) / length, 0);
+    }
+
+    // Positive when point is on the inner side of the given side of the box
+    static double SideDistance(Vector3 point, int side, Vector3 boxMin, Vector3 boxMax)
+    {
+        switch (side) {
+            case 0: return point.x - boxMin.x;
+            case 1: return boxMax.x - point.x;
+            case 2: return point.y - boxMin.y;
+            default: return boxMax.y - point.y;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "kinetic.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// Every frame moves this fraction of the points by up to MAX_STEP in each direction
+const int FRAMES = 10;
+const double MOVED_FRACTION = 0.01;
+const double MAX_STEP = 1.0;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_kinetic.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+    for (int i = 0; i < N; i++) {
+        bowyerWatson.AddPointAndRetriangulate(i);
+    }
+    bowyerWatson.RemoveSuperTriangle();
+
+    // Fixed seed, so every run moves the same points the same way
+    mt19937 generator(1);
+    uniform_int_distribution<int> pointDistribution(0, N - 1);
+    uniform_real_distribution<double> stepDistribution(-MAX_STEP, MAX_STEP);
+
+    KineticTriangulation<> kinetic = KineticTriangulation<>(triangulation);
+    int failed = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        vector<int> pointIds;
+        vector<Vector3> positions;
+        for (int i = 0; i < N * MOVED_FRACTION; i++) {
+            int pointId = pointDistribution(generator);
+            Vector3 position = triangulation.points[pointId];
+            position.x += stepDistribution(generator);
+            position.y += stepDistribution(generator);
+
+            pointIds.push_back(pointId);
+            positions.push_back(position);
+        }
+
+        failed += kinetic.MovePoints(pointIds, positions);
+    }
+
+    // Points on the hull (and the ones that would leave it) stay in place
+    cerr << failed << " moves left out" << endl;
+
+    triangulation.Print();
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "constrained.hpp"
+#include "navmesh.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <cstring>
+#include <random>
+
+using namespace std;
+
+// Paths between random points of the bounding box of the input
+const int PATHS = 1000;
+
+// Size of the grid of the wall test, the wall goes up the middle and leaves a gap of 2 cells at the top
+const int WALL_GRID = 300;
+
+// Triangulates a jittered grid with a wall up the middle, then checks the paths between the two sides against the
+// shortest one, which goes around the end of the wall. Returns the number of paths that aren't the shortest
+int CheckWall()
+{
+    mt19937 generator(5);
+    uniform_real_distribution<double> jitter(-3, 3);
+
+    vector<Vector3> points;
+    vector<int> wall;
+    for (int x = 0; x <= WALL_GRID; x += 10) {
+        for (int y = 0; y <= WALL_GRID; y += 10) {
+            bool onWall = x == WALL_GRID / 2 && y <= WALL_GRID - 20;
+            if (onWall) {
+                wall.push_back(points.size());
+            }
+
+            // The border and the wall stay straight
+            bool fixed = onWall || x == 0 || y == 0 || x == WALL_GRID || y == WALL_GRID;
+            points.push_back(fixed ? Vector3(x, y, 0) : Vector3(x + jitter(generator), y + jitter(generator), 0));
+        }
+    }
+    QuantizePoints(points, DefaultKernel());
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+    for (int i = 0; i < points.size(); i++) {
+        bowyerWatson.AddPointAndRetriangulate(i);
+    }
+    bowyerWatson.RemoveSuperTriangle();
+
+    ConstrainedDelaunay<> constrained = ConstrainedDelaunay<>(triangulation);
+    for (int i = 0; i + 1 < wall.size(); i++) {
+        constrained.InsertConstraint(wall[i], wall[i + 1]);
+    }
+
+    NavmeshPathfinder<> pathfinder = NavmeshPathfinder<>(triangulation);
+    Vector3 end = Vector3(WALL_GRID / 2, WALL_GRID - 20, 0);
+    uniform_real_distribution<double> position(1, WALL_GRID - 1);
+
+    int wrong = 0;
+    for (int i = 0; i < PATHS; i++) {
+        // One point on each side, below the end of the wall, so the line between them hits the wall
+        Vector3 start = Vector3(position(generator) / 2, position(generator) * 0.9, 0);
+        Vector3 goal = Vector3(WALL_GRID - position(generator) / 2, position(generator) * 0.9, 0);
+
+        vector<Vector3> path;
+        if (!pathfinder.FindPath(start, goal, path)) {
+            wrong++;
+            continue;
+        }
+
+        double length = 0;
+        for (int j = 0; j + 1 < path.size(); j++) {
+            length += GetDistance(path[j], path[j + 1]);
+        }
+        if (length > (GetDistance(start, end) + GetDistance(end, goal)) * (1 + 1e-9)) {
+            wrong++;
+        }
+    }
+
+    return wrong;
+}
+
+// Finds paths over the triangulation of the input:
+//   delaunay_navmesh [wall]
+// "wall" checks the paths around a wall instead, and exits with 1 if one of them isn't the shortest
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "wall") == 0) {
+        int wrong = CheckWall();
+        cout << wrong << " of " << PATHS << " paths around the wall aren't the shortest" << endl;
+        return wrong == 0 ? 0 : 1;
+    }
+
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_navmesh.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    double maxX = 0, maxY = 0;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+        maxX = max(maxX, x);
+        maxY = max(maxY, y);
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+    for (int i = 0; i < N; i++) {
+        bowyerWatson.AddPointAndRetriangulate(i);
+    }
+    bowyerWatson.RemoveSuperTriangle();
+
+    // Fixed seed, so every run asks for the same paths
+    mt19937 generator(1);
+    uniform_real_distribution<double> xDistribution(0, maxX);
+    uniform_real_distribution<double> yDistribution(0, maxY);
+
+    vector<Vector3> starts;
+    vector<Vector3> goals;
+    for (int i = 0; i < PATHS; i++) {
+        starts.push_back(Vector3(xDistribution(generator), yDistribution(generator), 0));
+        goals.push_back(Vector3(xDistribution(generator), yDistribution(generator), 0));
+    }
+
+    NavmeshPathfinder<> pathfinder = NavmeshPathfinder<>(triangulation);
+    vector<vector<Vector3>> paths;
+    int failed = pathfinder.FindPaths(starts, goals, paths);
+
+    // Points outside the triangulation have no path
+    cerr << failed << " paths not found" << endl;
+
+    // One line per path: the number of corners, then their coordinates
+    for (int i = 0; i < PATHS; i++) {
+        cout << paths[i].size();
+        for (int j = 0; j < paths[i].size(); j++) {
+            cout << " " << Triangulation::Format(paths[i][j].x) << " " << Triangulation::Format(paths[i][j].y);
+        }
+        cout << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "triangulation.hpp"
+#include "pipeline.hpp"
+#include "common.hpp"
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_pipeline.out", "w", stdout);
+    ios::sync_with_stdio(false);
+
+    // Reading, sorting, inserting and writing the points all happen at the same time
+    Triangulation triangulation;
+    TriangulationPipeline pipeline(triangulation);
+    pipeline.Run(cin, cout);
+    if (!pipeline.skippedPoints.empty()) {
+        cerr << pipeline.skippedPoints.size() << " points left out" << endl;
+    }
+
+    return 0;
+}
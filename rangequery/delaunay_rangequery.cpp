@@ -0,0 +1,77 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "rangequery.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// Half of the queries are rectangles, half circles, all of them up to MAX_SIZE wide
+const int QUERIES = 1000;
+const double MAX_SIZE = 100;
+const int CAPACITY = 4096;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_rangequery.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    double maxX = 0, maxY = 0;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+        maxX = max(maxX, x);
+        maxY = max(maxY, y);
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+    for (int i = 0; i < N; i++) {
+        bowyerWatson.AddPointAndRetriangulate(i);
+    }
+    bowyerWatson.RemoveSuperTriangle();
+
+    // Fixed seed, so every run asks the same queries
+    mt19937 generator(1);
+    uniform_real_distribution<double> xDistribution(0, maxX);
+    uniform_real_distribution<double> yDistribution(0, maxY);
+    uniform_real_distribution<double> sizeDistribution(0, MAX_SIZE);
+
+    vector<RangeQuery> queries;
+    for (int i = 0; i < QUERIES; i++) {
+        Vector3 corner(xDistribution(generator), yDistribution(generator), 0);
+        double size = sizeDistribution(generator);
+        if (i % 2 == 0) {
+            queries.push_back(RangeQuery::Rectangle(corner, Vector3(corner.x + size, corner.y + size, 0)));
+        } else {
+            queries.push_back(RangeQuery::Circle(corner, size / 2));
+        }
+    }
+
+    RangeQueries<> rangeQueries = RangeQueries<>(triangulation);
+    vector<int> results(QUERIES * CAPACITY);
+    vector<int> counts(QUERIES);
+    rangeQueries.QueryBatch(queries, &results[0], CAPACITY, &counts[0]);
+
+    // One line per query: the number of nodes found (-1 if more than CAPACITY), then their ids
+    for (int i = 0; i < QUERIES; i++) {
+        cout << counts[i];
+        for (int j = 0; j < counts[i]; j++) {
+            cout << " " << results[i * CAPACITY + j];
+        }
+        cout << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "refinement.hpp"
+#include "common.hpp"
+#include <iostream>
+
+using namespace std;
+
+// Quality targets for the refined mesh
+const double MIN_ANGLE = 20;
+const double MAX_AREA = 0;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_refinement.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+
+    // Insert close points one after the other so the walks stay short
+    vector<int> order;
+    for (int i = 0; i < N; i++) {
+        order.push_back(i);
+    }
+    SpatialSort(triangulation.points, order);
+
+    for (int i = 0; i < N; i++) {
+        bowyerWatson.AddPointAndRetriangulate(order[i]);
+    }
+
+    // Add points until all the triangles meet the quality targets, then drop the super triangle
+    DelaunayRefinement<> refinement = DelaunayRefinement<>(bowyerWatson, MIN_ANGLE, MAX_AREA);
+    refinement.Refine(N);
+    bowyerWatson.RemoveSuperTriangle();
+
+    triangulation.Print();
+
+    return 0;
+}
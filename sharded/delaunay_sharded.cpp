@@ -0,0 +1,47 @@
+#include "triangulation.hpp"
+#include "sharded.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <cstring>
+
+using namespace std;
+
+// The points are split in TILES_X x TILES_Y shards, each one triangulated by its own process
+const int TILES_X = 2;
+const int TILES_Y = 2;
+
+// Called as "delaunay_sharded worker <shard> <result>" by the coordinator for every shard
+int main(int argc, char** argv) {
+    if (argc == 4 && strcmp(argv[1], "worker") == 0) {
+        return ShardedTriangulation<>::TriangulateShard(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_sharded.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    ShardedTriangulation<> sharded = ShardedTriangulation<>(triangulation, TILES_X, TILES_Y);
+    if (!sharded.Triangulate()) {
+        cerr << "Sharded triangulation failed" << endl;
+        return 1;
+    }
+
+    triangulation.Print();
+
+    return 0;
+}
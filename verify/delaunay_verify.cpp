@@ -0,0 +1,63 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "verifier.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <cstring>
+#include <random>
+
+using namespace std;
+
+// Triangulates a tight gaussian cluster (sigma 1) with a few points far away around it, the small triangles of
+// the cluster are flat for the EPS tolerances of the double kernel
+void GenerateClustered(Triangulation& triangulation)
+{
+    mt19937 generator(27);
+    normal_distribution<double> cluster(500, 1);
+    uniform_real_distribution<double> far(0, 1000);
+
+    vector<Vector3> points;
+    for (int i = 0; i < 5000; i++) {
+        points.push_back(Vector3(cluster(generator), cluster(generator), 0));
+    }
+    for (int i = 0; i < 100; i++) {
+        points.push_back(Vector3(far(generator), far(generator), 0));
+    }
+    QuantizePoints(points, DefaultKernel());
+
+    triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+    for (int i = 0; i < points.size(); i++) {
+        bowyerWatson.AddPointAndRetriangulate(i);
+    }
+    bowyerWatson.RemoveSuperTriangle();
+}
+
+// Checks the output of one of the binaries, by default the bowyer-watson one:
+//   delaunay_verify [file] [any]
+// "any" allows clockwise triangles, for the output of the flip algorithm
+//   delaunay_verify clustered
+// checks a Bowyer-Watson triangulation of a clustered input instead of a file
+// Exits with 1 if the triangulation isn't valid
+int main(int argc, char** argv) {
+    const char* input = argc > 1 ? argv[1] : "data/delaunay_bowyerwatson.out";
+    bool counterclockwise = !(argc > 2 && strcmp(argv[2], "any") == 0);
+
+    Triangulation triangulation;
+    if (strcmp(input, "clustered") == 0) {
+        GenerateClustered(triangulation);
+    } else {
+        if (!freopen(input, "r", stdin)) {
+            cerr << "Can't open " << input << endl;
+            return 1;
+        }
+        triangulation.Read();
+    }
+
+    TriangulationVerifier<> verifier = TriangulationVerifier<>(DefaultKernel(), counterclockwise);
+    VerificationReport report = verifier.Verify(triangulation);
+    report.Print(cout);
+
+    return report.IsValid() ? 0 : 1;
+}
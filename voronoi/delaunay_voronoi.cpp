@@ -0,0 +1,55 @@
+#include "triangulation.hpp"
+#include "bowyerwatson.hpp"
+#include "voronoi.hpp"
+#include "common.hpp"
+#include <iostream>
+
+using namespace std;
+
+// How much the voronoi cells on the hull extend past the pointset
+const double VORONOI_MARGIN = 20;
+
+int main() {
+    freopen("data/delaunay.in", "r", stdin);
+    freopen("data/delaunay_voronoi.out", "w", stdout);
+
+    // Read the N input points
+    int N;
+    cin >> N;
+    vector<Vector3> points;
+    for (int i = 0; i < N; i++) {
+        double x, y;
+        cin >> x >> y;
+        points.push_back(Vector3(x, y, 0));
+    }
+
+    if (!QuantizePoints(points, DefaultKernel())) {
+        cerr << "Coordinates out of range for the kernel" << endl;
+        return 1;
+    }
+
+    Triangulation triangulation = Triangulation(points);
+    BowyerWatson<> bowyerWatson = BowyerWatson<>(triangulation);
+    bowyerWatson.GenerateSuperTriangle();
+
+    // Insert close points one after the other so the walks stay short
+    vector<int> order;
+    for (int i = 0; i < N; i++) {
+        order.push_back(i);
+    }
+    SpatialSort(triangulation.points, order);
+
+    for (int i = 0; i < N; i++) {
+        bowyerWatson.AddPointAndRetriangulate(order[i]);
+    }
+    bowyerWatson.RemoveSuperTriangle();
+
+    VoronoiDiagram voronoi;
+    voronoi.Build(triangulation, VORONOI_MARGIN);
+    if (!voronoi.brokenCells.empty()) {
+        cerr << voronoi.brokenCells.size() << " cells left empty" << endl;
+    }
+    voronoi.Print();
+
+    return 0;
+}